@@ -14,6 +14,14 @@ import tensorflow as _tf; del _tf
 # limitations under the License.
 
 """Courier module."""
+from courier.python.client import broadcast  # pytype: disable=import-error
 from courier.python.client import Client  # pytype: disable=import-error
+from courier.python.client import gather  # pytype: disable=import-error
 from courier.python.client import list_methods  # pytype: disable=import-error
+from courier.python.client import retry_stats  # pytype: disable=import-error
+from courier.python.client import Serialized  # pytype: disable=import-error
+from courier.python.client import subscribe  # pytype: disable=import-error
+from courier.python.client import Subscription  # pytype: disable=import-error
 from courier.python.py_server import Server  # pytype: disable=import-error
+from courier.python.sharded_client import ShardedClient  # pytype: disable=import-error
+from courier.python.versioning import VersionedPull  # pytype: disable=import-error
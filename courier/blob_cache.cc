@@ -0,0 +1,241 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/blob_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "openssl/sha.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "courier/courier_service.pb.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+namespace {
+
+// Calls `visit` on `object` and on all objects nested in it.
+template <typename Visit>
+void ForEachObject(SerializedObject* object, const Visit& visit) {
+  visit(object);
+  switch (object->payload_case()) {
+    case SerializedObject::kListValue:
+      for (auto& item : *object->mutable_list_value()->mutable_items()) {
+        ForEachObject(&item, visit);
+      }
+      break;
+    case SerializedObject::kDictValue:
+      for (auto& key : *object->mutable_dict_value()->mutable_keys()) {
+        ForEachObject(&key, visit);
+      }
+      for (auto& value : *object->mutable_dict_value()->mutable_values()) {
+        ForEachObject(&value, visit);
+      }
+      break;
+    case SerializedObject::kReducedObjectValue: {
+      ReducedObject* reduced = object->mutable_reduced_object_value();
+      if (reduced->has_args()) ForEachObject(reduced->mutable_args(), visit);
+      if (reduced->has_state()) ForEachObject(reduced->mutable_state(), visit);
+      if (reduced->has_items()) ForEachObject(reduced->mutable_items(), visit);
+      if (reduced->has_kvpairs()) {
+        ForEachObject(reduced->mutable_kvpairs(), visit);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  if (object->has_numpy_object_tensor()) {
+    for (auto& item :
+         *object->mutable_numpy_object_tensor()->mutable_payload()) {
+      ForEachObject(&item, visit);
+    }
+  }
+}
+
+template <typename Visit>
+void ForEachObject(CallArguments* arguments, const Visit& visit) {
+  for (auto& arg : *arguments->mutable_args()) {
+    ForEachObject(&arg, visit);
+  }
+  for (auto& kwarg : *arguments->mutable_kwargs()) {
+    ForEachObject(&kwarg.second, visit);
+  }
+}
+
+}  // namespace
+
+std::string BlobDigest(absl::string_view data) {
+  std::string digest(SHA256_DIGEST_LENGTH, '\0');
+  SHA256(reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+         reinterpret_cast<uint8_t*>(&digest[0]));
+  return digest;
+}
+
+void BlobCache::Insert(absl::string_view digest,
+                       std::shared_ptr<const std::string> data, int64_t size) {
+  if (size > max_bytes_) return;
+  absl::MutexLock lock(&mu_);
+  auto it = entries_.find(digest);
+  if (it != entries_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second.position);
+    if (it->second.data == nullptr) it->second.data = std::move(data);
+    return;
+  }
+  while (bytes_ + size > max_bytes_) {
+    auto evicted = entries_.find(lru_.back());
+    bytes_ -= evicted->second.size;
+    entries_.erase(evicted);
+    lru_.pop_back();
+  }
+  lru_.emplace_front(digest);
+  entries_[digest] = Entry{lru_.begin(), std::move(data), size};
+  bytes_ += size;
+}
+
+bool BlobCache::Contains(absl::string_view digest) {
+  absl::MutexLock lock(&mu_);
+  auto it = entries_.find(digest);
+  if (it == entries_.end()) return false;
+  lru_.splice(lru_.begin(), lru_, it->second.position);
+  return true;
+}
+
+std::shared_ptr<const std::string> BlobCache::Lookup(
+    absl::string_view digest) {
+  absl::MutexLock lock(&mu_);
+  auto it = entries_.find(digest);
+  if (it == entries_.end()) return nullptr;
+  lru_.splice(lru_.begin(), lru_, it->second.position);
+  return it->second.data;
+}
+
+void ReplaceBlobsByDigest(
+    int64_t min_blob_size, BlobCache* known, CallRequest* request,
+    absl::flat_hash_map<std::string, std::string>* payloads) {
+  absl::flat_hash_set<std::string> sent;
+  auto replace = [&](std::string* data, BlobReference* reference) {
+    std::string digest = BlobDigest(*data);
+    reference->set_digest(digest);
+    request->set_has_blob_digests(true);
+    if (sent.contains(digest) || payloads->contains(digest)) {
+      data->clear();
+    } else if (known->Contains(digest)) {
+      (*payloads)[digest] = std::move(*data);
+      data->clear();
+    } else {
+      known->Insert(digest, nullptr, data->size());
+      CachedBlob* blob = request->add_cached_blobs();
+      blob->set_digest(digest);
+      *blob->mutable_data() = std::move(*data);
+      data->clear();
+      sent.insert(std::move(digest));
+    }
+  };
+  ForEachObject(request->mutable_arguments(), [&](SerializedObject* object) {
+    if (object->has_string_value() &&
+        object->string_value().size() >= min_blob_size) {
+      std::string data = std::move(*object->mutable_string_value());
+      replace(&data, object->mutable_blob_value());
+    } else if (object->has_array_value() &&
+               object->array_value().data().size() >= min_blob_size) {
+      EncodedArray* array = object->mutable_array_value();
+      replace(array->mutable_data(), array->mutable_data_blob());
+    }
+  });
+}
+
+absl::Status AddMissingBlobs(
+    const CallResponse& response,
+    absl::flat_hash_map<std::string, std::string>* payloads,
+    CallRequest* request) {
+  for (const std::string& digest : response.missing_blobs()) {
+    auto it = payloads->find(digest);
+    if (it == payloads->end()) {
+      return absl::InternalError(
+          "Server reported a payload as missing which was sent with the "
+          "call.");
+    }
+    CachedBlob* blob = request->add_cached_blobs();
+    blob->set_digest(digest);
+    *blob->mutable_data() = std::move(it->second);
+    payloads->erase(it);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ResolveBlobDigests(BlobCache* cache, const CallRequest& request,
+                                CallArguments* arguments,
+                                std::vector<std::string>* missing) {
+  // The cache is shared by all clients: a payload cached under another
+  // digest than its own would be served in place of the real one.
+  for (const CachedBlob& blob : request.cached_blobs()) {
+    if (BlobDigest(blob.data()) != blob.digest()) {
+      return absl::InvalidArgumentError(
+          "Digest of a cached blob does not match its data.");
+    }
+  }
+  absl::flat_hash_map<absl::string_view, const std::string*> sent;
+  for (const CachedBlob& blob : request.cached_blobs()) {
+    sent[blob.digest()] = &blob.data();
+    if (!cache->Contains(blob.digest())) {
+      cache->Insert(blob.digest(), std::make_shared<std::string>(blob.data()),
+                    blob.data().size());
+    }
+  }
+  auto resolve = [&](const BlobReference& reference, std::string* data) {
+    auto it = sent.find(reference.digest());
+    if (it != sent.end()) {
+      *data = *it->second;
+      return true;
+    }
+    std::shared_ptr<const std::string> cached =
+        cache->Lookup(reference.digest());
+    if (cached == nullptr) {
+      if (std::find(missing->begin(), missing->end(), reference.digest()) ==
+          missing->end()) {
+        missing->push_back(reference.digest());
+      }
+      return false;
+    }
+    *data = *cached;
+    return true;
+  };
+  ForEachObject(arguments, [&](SerializedObject* object) {
+    if (object->has_blob_value() && !object->blob_value().digest().empty()) {
+      std::string data;
+      if (resolve(object->blob_value(), &data)) {
+        *object->mutable_string_value() = std::move(data);
+      }
+    } else if (object->has_array_value() &&
+               object->array_value().has_data_blob() &&
+               !object->array_value().data_blob().digest().empty()) {
+      EncodedArray* array = object->mutable_array_value();
+      if (resolve(array->data_blob(), array->mutable_data())) {
+        array->clear_data_blob();
+      }
+    }
+  });
+  return absl::OkStatus();
+}
+
+}  // namespace courier
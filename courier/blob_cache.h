@@ -0,0 +1,112 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_BLOB_CACHE_H_
+#define COURIER_BLOB_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "courier/courier_service.pb.h"
+
+namespace courier {
+
+// Lets a client send large call arguments which it already sent before by
+// digest only. The server keeps the payloads it received in a `BlobCache`
+// and asks for the ones it does not hold (anymore), see
+// `CallResponse.missing_blobs`.
+struct BlobCacheOptions {
+  // Bytes and array payloads of at least this size are sent by digest.
+  int64_t min_blob_size = 64 << 10;
+
+  // Total size of the payloads the client assumes the server to hold. Should
+  // not exceed the capacity of the cache of the server.
+  int64_t max_bytes = 256 << 20;
+};
+
+// Returns the SHA-256 digest identifying `data` in a blob cache.
+std::string BlobDigest(absl::string_view data);
+
+// Payloads keyed by digest, evicting the least recently used ones beyond a
+// total size. Clients keep the digests of the payloads they sent without
+// their data, to guess which ones the server holds. Thread-safe.
+class BlobCache {
+ public:
+  explicit BlobCache(int64_t max_bytes) : max_bytes_(max_bytes) {}
+
+  // Adds a payload of `size` bytes. `data` may be null if only its digest is
+  // of interest. Payloads larger than the capacity are not added.
+  void Insert(absl::string_view digest,
+              std::shared_ptr<const std::string> data, int64_t size)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Whether the payload is held, marking it as recently used.
+  bool Contains(absl::string_view digest) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns the data of the payload, null if it is not held.
+  std::shared_ptr<const std::string> Lookup(absl::string_view digest)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    std::list<std::string>::iterator position;
+    std::shared_ptr<const std::string> data;
+    int64_t size;
+  };
+
+  const int64_t max_bytes_;
+
+  absl::Mutex mu_;
+  // Digests, the most recently used first.
+  std::list<std::string> lru_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<std::string, Entry> entries_ ABSL_GUARDED_BY(mu_);
+  int64_t bytes_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+// Replaces the payloads of `request` of at least `min_blob_size` by
+// references to their digest. Payloads not in `known` are also added to
+// `cached_blobs` and to `known`; the others are moved to `payloads`, to be
+// sent again by `AddMissingBlobs` if the server no longer holds them.
+void ReplaceBlobsByDigest(int64_t min_blob_size, BlobCache* known,
+                          CallRequest* request,
+                          absl::flat_hash_map<std::string, std::string>*
+                              payloads);
+
+// Moves the payloads the server reported as missing from `payloads` to the
+// `cached_blobs` of `request`.
+absl::Status AddMissingBlobs(
+    const CallResponse& response,
+    absl::flat_hash_map<std::string, std::string>* payloads,
+    CallRequest* request);
+
+// Adds the `cached_blobs` of `request` to `cache` and resolves the references
+// by digest of `arguments`, a copy of the arguments of `request`. The digests
+// of payloads neither in `cache` nor in the request are added to `missing`.
+// Fails with `InvalidArgument`, leaving `cache` untouched, if the digest of a
+// payload of the request does not match its data.
+absl::Status ResolveBlobDigests(BlobCache* cache, const CallRequest& request,
+                                CallArguments* arguments,
+                                std::vector<std::string>* missing);
+
+}  // namespace courier
+
+#endif  // COURIER_BLOB_CACHE_H_
@@ -0,0 +1,74 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/blob_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "courier/courier_service.pb.h"
+
+namespace courier {
+namespace {
+
+constexpr int64_t kMinBlobSize = 16;
+
+// Returns a request whose only argument is sent by digest.
+CallRequest RequestWithBlob(const std::string& data) {
+  BlobCache known(1 << 20);
+  CallRequest request;
+  request.mutable_arguments()->add_args()->set_string_value(data);
+  absl::flat_hash_map<std::string, std::string> payloads;
+  ReplaceBlobsByDigest(kMinBlobSize, &known, &request, &payloads);
+  return request;
+}
+
+TEST(BlobCacheTest, ResolvesDigests) {
+  const std::string data(100, 'a');
+  CallRequest request = RequestWithBlob(data);
+  ASSERT_EQ(request.cached_blobs_size(), 1);
+
+  BlobCache cache(1 << 20);
+  CallArguments arguments = request.arguments();
+  std::vector<std::string> missing;
+  ASSERT_TRUE(
+      ResolveBlobDigests(&cache, request, &arguments, &missing).ok());
+  EXPECT_TRUE(missing.empty());
+  EXPECT_EQ(arguments.args(0).string_value(), data);
+  EXPECT_TRUE(cache.Contains(BlobDigest(data)));
+}
+
+TEST(BlobCacheTest, RejectsForgedDigest) {
+  const std::string data(100, 'a');
+  const std::string forged(100, 'b');
+  CallRequest request = RequestWithBlob(data);
+  ASSERT_EQ(request.cached_blobs_size(), 1);
+  // Claims that the digest of `data` identifies `forged`.
+  request.mutable_cached_blobs(0)->set_data(forged);
+
+  BlobCache cache(1 << 20);
+  CallArguments arguments = request.arguments();
+  std::vector<std::string> missing;
+  absl::Status status =
+      ResolveBlobDigests(&cache, request, &arguments, &missing);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_FALSE(cache.Contains(BlobDigest(data)));
+  EXPECT_FALSE(cache.Contains(BlobDigest(forged)));
+}
+
+}  // namespace
+}  // namespace courier
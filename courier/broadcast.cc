@@ -0,0 +1,78 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/broadcast.h"
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/types/span.h"
+#include "courier/call_context.h"
+#include "courier/client.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+std::vector<std::shared_ptr<CallContext>> AsyncBroadcastF(
+    absl::Span<Client* const> clients, absl::string_view method_name,
+    std::unique_ptr<courier::CallArguments> arguments,
+    const BroadcastOptions& options,
+    std::function<void(int, absl::StatusOr<courier::CallResult>)> callback) {
+  absl::StatusOr<SerializedCallRequest> request =
+      Client::SerializeCallRequest(method_name, std::move(arguments));
+  auto shared_callback =
+      std::make_shared<std::function<void(int, absl::StatusOr<CallResult>)>>(
+          std::move(callback));
+  std::vector<std::shared_ptr<CallContext>> contexts;
+  contexts.reserve(clients.size());
+  for (int i = 0; i < clients.size(); ++i) {
+    auto context = std::make_shared<CallContext>(
+        options.timeout, options.wait_for_ready, options.compress);
+    contexts.push_back(context);
+    if (!request.ok()) {
+      (*shared_callback)(i, request.status());
+      continue;
+    }
+    clients[i]->AsyncSerializedCallF(
+        context.get(), *request,
+        [i, context, shared_callback](absl::StatusOr<CallResult> result) {
+          (*shared_callback)(i, std::move(result));
+        });
+  }
+  return contexts;
+}
+
+std::vector<absl::StatusOr<courier::CallResult>> GatherF(
+    absl::Span<Client* const> clients, absl::string_view method_name,
+    std::unique_ptr<courier::CallArguments> arguments,
+    const BroadcastOptions& options) {
+  std::vector<absl::StatusOr<CallResult>> results(clients.size());
+  absl::BlockingCounter counter(clients.size());
+  AsyncBroadcastF(
+      clients, method_name, std::move(arguments), options,
+      [&results, &counter](int i, absl::StatusOr<CallResult> result) {
+        results[i] = std::move(result);
+        counter.DecrementCount();
+      });
+  counter.Wait();
+  return results;
+}
+
+}  // namespace courier
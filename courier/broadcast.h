@@ -0,0 +1,62 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_BROADCAST_H_
+#define COURIER_BROADCAST_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "courier/call_context.h"
+#include "courier/client.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+struct BroadcastOptions {
+  // Settings of the `CallContext` of every call. With a `timeout`, calls
+  // still in flight when it expires fail with `DeadlineExceeded`.
+  absl::Duration timeout = absl::ZeroDuration();
+  bool wait_for_ready = true;
+  bool compress = false;
+};
+
+// Calls `method_name` with the same `arguments` on every client of `clients`.
+// The request is serialized once and its buffer shared by all the calls,
+// which run concurrently. `callback` is invoked on a completion queue polling
+// thread with the index of the client and the outcome of its call, so it must
+// not block. The caller retains ownership of the clients which must outlive
+// the calls. Returns the contexts of the calls, in the order of `clients`,
+// through which they can be cancelled.
+std::vector<std::shared_ptr<CallContext>> AsyncBroadcastF(
+    absl::Span<Client* const> clients, absl::string_view method_name,
+    std::unique_ptr<courier::CallArguments> arguments,
+    const BroadcastOptions& options,
+    std::function<void(int, absl::StatusOr<courier::CallResult>)> callback);
+
+// Same as `AsyncBroadcastF` but blocks until all calls have completed and
+// returns their outcomes in the order of `clients`.
+std::vector<absl::StatusOr<courier::CallResult>> GatherF(
+    absl::Span<Client* const> clients, absl::string_view method_name,
+    std::unique_ptr<courier::CallArguments> arguments,
+    const BroadcastOptions& options = BroadcastOptions());
+
+}  // namespace courier
+
+#endif  // COURIER_BROADCAST_H_
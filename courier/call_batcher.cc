@@ -0,0 +1,149 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/call_batcher.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "courier/call_context.h"
+#include "courier/client.h"
+#include "courier/courier_service.pb.h"
+
+namespace courier {
+
+CallBatcher::CallBatcher(Client* client, const CallBatcherOptions& options)
+    : client_(client),
+      options_(options),
+      request_(absl::make_unique<BatchCallRequest>()) {
+  thread_ = std::thread(&CallBatcher::Run, this);
+}
+
+CallBatcher::~CallBatcher() {
+  {
+    absl::MutexLock lock(&mu_);
+    stopping_ = true;
+  }
+  thread_.join();
+  absl::MutexLock lock(&mu_);
+  // Batches retrying against an unreachable server would never complete.
+  for (CallContext* context : batches_in_flight_) context->Cancel();
+  mu_.Await(absl::Condition(
+      +[](absl::flat_hash_set<CallContext*>* batches_in_flight) {
+        return batches_in_flight->empty();
+      },
+      &batches_in_flight_));
+}
+
+void CallBatcher::AsyncCallF(
+    absl::string_view method_name,
+    std::unique_ptr<courier::CallArguments> arguments,
+    std::function<void(absl::StatusOr<courier::CallResult>)> callback) {
+  absl::MutexLock lock(&mu_);
+  if (callbacks_.empty()) first_call_time_ = absl::Now();
+  CallRequest* call = request_->add_calls();
+  call->set_method(std::string(method_name));
+  call->set_allocated_arguments(arguments.release());
+  callbacks_.push_back(std::move(callback));
+}
+
+bool CallBatcher::HasWork() const { return stopping_ || !callbacks_.empty(); }
+
+bool CallBatcher::BatchReady() const {
+  return stopping_ || callbacks_.size() >= options_.max_batch_size;
+}
+
+void CallBatcher::Run() {
+  const int max_batch_size = std::max(options_.max_batch_size, 1);
+  mu_.Lock();
+  while (true) {
+    mu_.Await(absl::Condition(this, &CallBatcher::HasWork));
+    if (callbacks_.empty()) break;  // Stopping.
+    mu_.AwaitWithDeadline(absl::Condition(this, &CallBatcher::BatchReady),
+                          first_call_time_ + options_.max_delay);
+
+    auto request = absl::make_unique<BatchCallRequest>();
+    std::vector<Callback> callbacks;
+    if (callbacks_.size() <= max_batch_size) {
+      request.swap(request_);
+      callbacks.swap(callbacks_);
+    } else {
+      // Send the oldest calls, the others form the next batch.
+      auto* calls = request_->mutable_calls();
+      for (int i = 0; i < max_batch_size; ++i) {
+        *request->add_calls() = std::move(*calls->Mutable(i));
+      }
+      calls->DeleteSubrange(0, max_batch_size);
+      callbacks.assign(
+          std::make_move_iterator(callbacks_.begin()),
+          std::make_move_iterator(callbacks_.begin() + max_batch_size));
+      callbacks_.erase(callbacks_.begin(), callbacks_.begin() + max_batch_size);
+    }
+
+    mu_.Unlock();
+    Send(std::move(request), std::move(callbacks));
+    mu_.Lock();
+  }
+  mu_.Unlock();
+}
+
+void CallBatcher::Send(std::unique_ptr<BatchCallRequest> request,
+                       std::vector<Callback> callbacks) {
+  auto context = std::make_shared<CallContext>(
+      options_.timeout, options_.wait_for_ready, options_.compress);
+  {
+    absl::MutexLock lock(&mu_);
+    batches_in_flight_.insert(context.get());
+  }
+  auto shared_callbacks =
+      std::make_shared<std::vector<Callback>>(std::move(callbacks));
+  client_->AsyncBatchCallF(
+      context.get(), std::move(request),
+      [this, context, callbacks = std::move(shared_callbacks)](
+          absl::StatusOr<BatchCallResponse> response) {
+        for (int i = 0; i < callbacks->size(); ++i) {
+          if (!response.ok()) {
+            (*callbacks)[i](response.status());
+          } else if (i >= response->results_size()) {
+            (*callbacks)[i](
+                absl::InternalError("Batch call response is missing results."));
+          } else {
+            BatchCallResult* result = response->mutable_results(i);
+            if (result->code() == 0) {
+              (*callbacks)[i](std::move(*result->mutable_result()));
+            } else {
+              (*callbacks)[i](
+                  absl::Status(static_cast<absl::StatusCode>(result->code()),
+                               result->message()));
+            }
+          }
+        }
+        absl::MutexLock lock(&mu_);
+        batches_in_flight_.erase(context.get());
+      });
+}
+
+}  // namespace courier
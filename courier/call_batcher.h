@@ -0,0 +1,103 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_CALL_BATCHER_H_
+#define COURIER_CALL_BATCHER_H_
+
+#include <functional>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "courier/call_context.h"
+#include "courier/client.h"
+#include "courier/courier_service.pb.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+struct CallBatcherOptions {
+  // Maximum number of calls sent in a single batch.
+  int max_batch_size = 64;
+
+  // Maximum time a call waits for other calls to join its batch.
+  absl::Duration max_delay = absl::Microseconds(500);
+
+  // Settings of the `CallContext` of every batch.
+  absl::Duration timeout = absl::ZeroDuration();
+  bool wait_for_ready = true;
+  bool compress = false;
+};
+
+// Groups small asynchronous calls into `BatchCall` RPCs, saving the per-RPC
+// overhead on both ends. A batch is sent once it holds `max_batch_size` calls
+// or its first call has waited for `max_delay`. Every call still completes
+// individually, with its own result or error. Thread-safe.
+class CallBatcher {
+ public:
+  // The caller retains ownership of `client` which must outlive the batcher.
+  explicit CallBatcher(
+      Client* client, const CallBatcherOptions& options = CallBatcherOptions());
+
+  // Sends the calls which are still queued, cancels the batches in flight and
+  // blocks until all calls have completed.
+  ~CallBatcher();
+
+  // Queues a call for the next batch. `callback` is invoked on a completion
+  // queue polling thread of the client, so it must not block.
+  void AsyncCallF(
+      absl::string_view method_name,
+      std::unique_ptr<courier::CallArguments> arguments,
+      std::function<void(absl::StatusOr<courier::CallResult>)> callback)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  using Callback = std::function<void(absl::StatusOr<courier::CallResult>)>;
+
+  // Sends the queued calls in batches until the batcher is destroyed.
+  void Run() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Sends a batch and dispatches its results to `callbacks`.
+  void Send(std::unique_ptr<BatchCallRequest> request,
+            std::vector<Callback> callbacks) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Conditions of `Run`.
+  bool HasWork() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  bool BatchReady() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Client* const client_;
+  const CallBatcherOptions options_;
+
+  absl::Mutex mu_;
+  // Calls of the next batch.
+  std::unique_ptr<BatchCallRequest> request_ ABSL_GUARDED_BY(mu_);
+  std::vector<Callback> callbacks_ ABSL_GUARDED_BY(mu_);
+  // Time at which the first call of the next batch was queued.
+  absl::Time first_call_time_ ABSL_GUARDED_BY(mu_);
+  // Contexts of the batches which have been sent but not completed yet.
+  absl::flat_hash_set<CallContext*> batches_in_flight_ ABSL_GUARDED_BY(mu_);
+  bool stopping_ ABSL_GUARDED_BY(mu_) = false;
+
+  std::thread thread_;
+};
+
+}  // namespace courier
+
+#endif  // COURIER_CALL_BATCHER_H_
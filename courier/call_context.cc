@@ -14,8 +14,12 @@
 
 #include "courier/call_context.h"
 
+#include <algorithm>
+
 #include "absl/memory/memory.h"
+#include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "courier/platform/logging.h"
 
@@ -31,6 +35,14 @@ CallContext::CallContext(absl::Duration timeout, bool wait_for_ready,
       context_(NewContext()) {
 }
 
+CallContext::CallContext(absl::Time deadline, bool wait_for_ready,
+                         bool compress)
+    : deadline_(deadline),
+      wait_for_ready_(wait_for_ready),
+      compress_(compress),
+      cancelled_(false),
+      context_(NewContext()) {}
+
 CallContext::~CallContext() {
 }
 
@@ -38,6 +50,23 @@ void CallContext::Cancel() {
   absl::WriterMutexLock lock(&mu_);
   cancelled_ = true;
   context_->TryCancel();
+  for (CallContext* attempt : attempts_) attempt->Cancel();
+  if (retry_alarm_ != nullptr) retry_alarm_->Cancel();
+}
+
+std::unique_ptr<CallContext> CallContext::NewAttempt() {
+  // Not `absl::make_unique` as the constructor is private.
+  std::unique_ptr<CallContext> attempt(
+      new CallContext(deadline_, wait_for_ready_, compress_));
+  absl::WriterMutexLock lock(&mu_);
+  if (cancelled_) attempt->Cancel();
+  attempts_.push_back(attempt.get());
+  return attempt;
+}
+
+void CallContext::ReleaseAttempts() {
+  absl::WriterMutexLock lock(&mu_);
+  attempts_.clear();
 }
 
 void CallContext::Reset() {
@@ -51,6 +80,44 @@ grpc::ClientContext* CallContext::context() {
   return context_.get();
 }
 
+absl::Status CallContext::WaitForRetry(absl::Duration delay) {
+  absl::Time wake_up = absl::Now() + delay;
+  absl::MutexLock lock(&mu_);
+  mu_.AwaitWithDeadline(absl::Condition(&cancelled_),
+                        std::min(wake_up, deadline_));
+  if (cancelled_) {
+    return absl::CancelledError("Call cancelled while waiting to retry.");
+  }
+  if (deadline_ <= wake_up) {
+    return absl::DeadlineExceededError(
+        "Deadline exceeded while waiting to retry.");
+  }
+  return absl::OkStatus();
+}
+
+void CallContext::SetRetryAlarm(absl::Duration delay, grpc::Alarm* alarm,
+                                grpc::CompletionQueue* cq, void* tag) {
+  absl::Time wake_up = std::min(absl::Now() + delay, deadline_);
+  absl::WriterMutexLock lock(&mu_);
+  alarm->Set(cq, absl::ToChronoTime(wake_up), tag);
+  retry_alarm_ = alarm;
+  if (cancelled_) alarm->Cancel();
+}
+
+absl::Status CallContext::RetryAlarmDone(bool ok) {
+  absl::WriterMutexLock lock(&mu_);
+  retry_alarm_ = nullptr;
+  // Only `Cancel()` cancels the alarm.
+  if (cancelled_ || !ok) {
+    return absl::CancelledError("Call cancelled while waiting to retry.");
+  }
+  if (deadline_ <= absl::Now()) {
+    return absl::DeadlineExceededError(
+        "Deadline exceeded while waiting to retry.");
+  }
+  return absl::OkStatus();
+}
+
 std::unique_ptr<grpc::ClientContext> CallContext::NewContext() const {
   auto context = absl::make_unique<grpc::ClientContext>();
 
@@ -15,7 +15,12 @@
 #ifndef COURIER_CALL_CONTEXT_H_
 #define COURIER_CALL_CONTEXT_H_
 
+#include <memory>
+#include <vector>
+
+#include "grpcpp/alarm.h"
 #include "grpcpp/grpcpp.h"
+#include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 
@@ -50,9 +55,43 @@ class CallContext {
   // ONLY FOR INTERNAL USE.
   grpc::ClientContext* context();
 
+  // ONLY FOR INTERNAL USE.
+  // Waits `delay` before the next attempt of a call. Returns `Cancelled` as
+  // soon as `Cancel()` is called and `DeadlineExceeded` if the deadline of
+  // the call passes first. Thread-safe.
+  absl::Status WaitForRetry(absl::Duration delay);
+
+  // ONLY FOR INTERNAL USE.
+  // Asynchronous version of `WaitForRetry`: sets `alarm` to notify `tag` on
+  // `cq` once `delay` has elapsed, or at the deadline of the call if that is
+  // earlier. `Cancel()` cancels the alarm, which then notifies `tag` right
+  // away. Thread-safe.
+  void SetRetryAlarm(absl::Duration delay, grpc::Alarm* alarm,
+                     grpc::CompletionQueue* cq, void* tag);
+
+  // ONLY FOR INTERNAL USE.
+  // Must be called once the alarm set by `SetRetryAlarm` has notified its
+  // tag, with the `ok` of the notification, and before the alarm is
+  // destroyed. Returns the outcome of the wait like `WaitForRetry`.
+  // Thread-safe.
+  absl::Status RetryAlarmDone(bool ok);
+
+  // ONLY FOR INTERNAL USE.
+  // Creates a context with the same deadline and settings for one of several
+  // concurrent attempts of a call made with this context. Cancelling this
+  // context cancels the attempts until `ReleaseAttempts()` is called, which
+  // must happen before this context is destroyed. Thread-safe.
+  std::unique_ptr<CallContext> NewAttempt();
+
+  // ONLY FOR INTERNAL USE.
+  // Stops forwarding the cancellation to the attempts. Thread-safe.
+  void ReleaseAttempts();
+
   bool wait_for_ready() const { return wait_for_ready_; }
 
  private:
+  CallContext(absl::Time deadline, bool wait_for_ready, bool compress);
+
   std::unique_ptr<grpc::ClientContext> NewContext() const;
 
   // Used to set `deadline` when creating a new context.
@@ -68,6 +107,10 @@ class CallContext {
   // The GRPC client context.
   bool cancelled_ ABSL_GUARDED_BY(mu_);
   std::unique_ptr<grpc::ClientContext> context_ ABSL_GUARDED_BY(mu_);
+  // Attempts created by `NewAttempt` which have not been released.
+  std::vector<CallContext*> attempts_ ABSL_GUARDED_BY(mu_);
+  // Alarm set by `SetRetryAlarm` which has not notified its tag yet.
+  grpc::Alarm* retry_alarm_ ABSL_GUARDED_BY(mu_) = nullptr;
   absl::Mutex mu_;
 };
 
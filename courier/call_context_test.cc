@@ -0,0 +1,86 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/call_context.h"
+
+#include "grpcpp/alarm.h"
+#include "grpcpp/completion_queue.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace courier {
+namespace {
+
+// Waits for the notification of the alarm and returns its `ok`.
+bool WaitForAlarm(grpc::CompletionQueue* cq, void* expected_tag) {
+  void* tag;
+  bool ok;
+  EXPECT_TRUE(cq->Next(&tag, &ok));
+  EXPECT_EQ(tag, expected_tag);
+  return ok;
+}
+
+TEST(CallContextTest, RetryAlarmFiresAfterDelay) {
+  grpc::CompletionQueue cq;
+  grpc::Alarm alarm;
+  CallContext context;
+  int tag;
+  context.SetRetryAlarm(absl::Milliseconds(10), &alarm, &cq, &tag);
+  EXPECT_TRUE(context.RetryAlarmDone(WaitForAlarm(&cq, &tag)).ok());
+  cq.Shutdown();
+}
+
+TEST(CallContextTest, CancelCancelsRetryAlarm) {
+  grpc::CompletionQueue cq;
+  grpc::Alarm alarm;
+  CallContext context;
+  int tag;
+  const absl::Time start = absl::Now();
+  context.SetRetryAlarm(absl::Hours(1), &alarm, &cq, &tag);
+  context.Cancel();
+  EXPECT_EQ(context.RetryAlarmDone(WaitForAlarm(&cq, &tag)).code(),
+            absl::StatusCode::kCancelled);
+  EXPECT_LT(absl::Now() - start, absl::Minutes(1));
+  cq.Shutdown();
+}
+
+TEST(CallContextTest, RetryAlarmSetAfterCancelFiresRightAway) {
+  grpc::CompletionQueue cq;
+  grpc::Alarm alarm;
+  CallContext context;
+  int tag;
+  context.Cancel();
+  context.SetRetryAlarm(absl::Hours(1), &alarm, &cq, &tag);
+  EXPECT_EQ(context.RetryAlarmDone(WaitForAlarm(&cq, &tag)).code(),
+            absl::StatusCode::kCancelled);
+  cq.Shutdown();
+}
+
+TEST(CallContextTest, RetryAlarmFiresAtDeadline) {
+  grpc::CompletionQueue cq;
+  grpc::Alarm alarm;
+  CallContext context(absl::Milliseconds(10));
+  int tag;
+  const absl::Time start = absl::Now();
+  context.SetRetryAlarm(absl::Hours(1), &alarm, &cq, &tag);
+  EXPECT_EQ(context.RetryAlarmDone(WaitForAlarm(&cq, &tag)).code(),
+            absl::StatusCode::kDeadlineExceeded);
+  EXPECT_LT(absl::Now() - start, absl::Minutes(1));
+  cq.Shutdown();
+}
+
+}  // namespace
+}  // namespace courier
@@ -0,0 +1,308 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/chunking.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "courier/courier_service.pb.h"
+#include "courier/platform/status_macros.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+namespace {
+
+int64_t AddBlob(std::string* payload, std::vector<std::string>* blobs) {
+  blobs->push_back(std::move(*payload));
+  payload->clear();
+  return blobs->size() - 1;
+}
+
+// The payloads referenced by a message, each of which can be taken once.
+struct Blobs {
+  explicit Blobs(std::vector<std::string>* data)
+      : data(data), taken(data->size(), false) {}
+
+  std::vector<std::string>* data;
+  std::vector<bool> taken;
+};
+
+absl::StatusOr<std::string> TakeBlob(const BlobReference& reference,
+                                     Blobs* blobs) {
+  if (reference.index() < 0 || reference.index() >= blobs->data->size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid blob reference: ", reference.index()));
+  }
+  // A payload is moved out on first use, a second reference would silently
+  // get an empty one.
+  if (blobs->taken[reference.index()]) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Blob referenced twice: ", reference.index()));
+  }
+  blobs->taken[reference.index()] = true;
+  return std::move((*blobs->data)[reference.index()]);
+}
+
+}  // namespace
+
+void ExtractBlobs(int64_t min_blob_size, SerializedObject* object,
+                  std::vector<std::string>* blobs) {
+  switch (object->payload_case()) {
+    case SerializedObject::kStringValue:
+      if (object->string_value().size() >= min_blob_size) {
+        int64_t index = AddBlob(object->mutable_string_value(), blobs);
+        object->mutable_blob_value()->set_index(index);
+      }
+      break;
+    case SerializedObject::kArrayValue: {
+      EncodedArray* array = object->mutable_array_value();
+      if (array->data().size() >= min_blob_size) {
+        array->mutable_data_blob()->set_index(
+            AddBlob(array->mutable_data(), blobs));
+      }
+      break;
+    }
+    case SerializedObject::kListValue:
+      for (auto& item : *object->mutable_list_value()->mutable_items()) {
+        ExtractBlobs(min_blob_size, &item, blobs);
+      }
+      break;
+    case SerializedObject::kDictValue:
+      for (auto& key : *object->mutable_dict_value()->mutable_keys()) {
+        ExtractBlobs(min_blob_size, &key, blobs);
+      }
+      for (auto& value : *object->mutable_dict_value()->mutable_values()) {
+        ExtractBlobs(min_blob_size, &value, blobs);
+      }
+      break;
+    case SerializedObject::kReducedObjectValue: {
+      ReducedObject* reduced = object->mutable_reduced_object_value();
+      if (reduced->has_args()) {
+        ExtractBlobs(min_blob_size, reduced->mutable_args(), blobs);
+      }
+      if (reduced->has_state()) {
+        ExtractBlobs(min_blob_size, reduced->mutable_state(), blobs);
+      }
+      if (reduced->has_items()) {
+        ExtractBlobs(min_blob_size, reduced->mutable_items(), blobs);
+      }
+      if (reduced->has_kvpairs()) {
+        ExtractBlobs(min_blob_size, reduced->mutable_kvpairs(), blobs);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  if (object->has_numpy_object_tensor()) {
+    for (auto& item :
+         *object->mutable_numpy_object_tensor()->mutable_payload()) {
+      ExtractBlobs(min_blob_size, &item, blobs);
+    }
+  }
+}
+
+void ExtractBlobs(int64_t min_blob_size, CallArguments* arguments,
+                  std::vector<std::string>* blobs) {
+  for (auto& arg : *arguments->mutable_args()) {
+    ExtractBlobs(min_blob_size, &arg, blobs);
+  }
+  for (auto& kwarg : *arguments->mutable_kwargs()) {
+    ExtractBlobs(min_blob_size, &kwarg.second, blobs);
+  }
+}
+
+namespace {
+
+absl::Status Restore(Blobs* blobs, SerializedObject* object) {
+  switch (object->payload_case()) {
+    case SerializedObject::kBlobValue: {
+      COURIER_ASSIGN_OR_RETURN(std::string blob,
+                               TakeBlob(object->blob_value(), blobs));
+      object->set_string_value(std::move(blob));
+      break;
+    }
+    case SerializedObject::kArrayValue: {
+      EncodedArray* array = object->mutable_array_value();
+      if (array->has_data_blob()) {
+        COURIER_ASSIGN_OR_RETURN(*array->mutable_data(),
+                                 TakeBlob(array->data_blob(), blobs));
+        array->clear_data_blob();
+      }
+      break;
+    }
+    case SerializedObject::kListValue:
+      for (auto& item : *object->mutable_list_value()->mutable_items()) {
+        COURIER_RETURN_IF_ERROR(Restore(blobs, &item));
+      }
+      break;
+    case SerializedObject::kDictValue:
+      for (auto& key : *object->mutable_dict_value()->mutable_keys()) {
+        COURIER_RETURN_IF_ERROR(Restore(blobs, &key));
+      }
+      for (auto& value : *object->mutable_dict_value()->mutable_values()) {
+        COURIER_RETURN_IF_ERROR(Restore(blobs, &value));
+      }
+      break;
+    case SerializedObject::kReducedObjectValue: {
+      ReducedObject* reduced = object->mutable_reduced_object_value();
+      if (reduced->has_args()) {
+        COURIER_RETURN_IF_ERROR(Restore(blobs, reduced->mutable_args()));
+      }
+      if (reduced->has_state()) {
+        COURIER_RETURN_IF_ERROR(Restore(blobs, reduced->mutable_state()));
+      }
+      if (reduced->has_items()) {
+        COURIER_RETURN_IF_ERROR(Restore(blobs, reduced->mutable_items()));
+      }
+      if (reduced->has_kvpairs()) {
+        COURIER_RETURN_IF_ERROR(Restore(blobs, reduced->mutable_kvpairs()));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  if (object->has_numpy_object_tensor()) {
+    for (auto& item :
+         *object->mutable_numpy_object_tensor()->mutable_payload()) {
+      COURIER_RETURN_IF_ERROR(Restore(blobs, &item));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status RestoreBlobs(std::vector<std::string>* blobs,
+                          SerializedObject* object) {
+  Blobs taken(blobs);
+  return Restore(&taken, object);
+}
+
+absl::Status RestoreBlobs(std::vector<std::string>* blobs,
+                          CallArguments* arguments) {
+  Blobs taken(blobs);
+  for (auto& arg : *arguments->mutable_args()) {
+    COURIER_RETURN_IF_ERROR(Restore(&taken, &arg));
+  }
+  for (auto& kwarg : *arguments->mutable_kwargs()) {
+    COURIER_RETURN_IF_ERROR(Restore(&taken, &kwarg.second));
+  }
+  return absl::OkStatus();
+}
+
+bool WriteChunks(const CallChunk& header, const std::vector<std::string>& blobs,
+                 int64_t chunk_size,
+                 const std::function<bool(const CallChunk&)>& write) {
+  CallChunk first = header;
+  first.mutable_blob_sizes()->Reserve(blobs.size());
+  for (const std::string& blob : blobs) {
+    first.add_blob_sizes(blob.size());
+  }
+  if (!write(first)) return false;
+
+  CallChunk chunk;
+  for (const std::string& blob : blobs) {
+    for (size_t offset = 0; offset < blob.size(); offset += chunk_size) {
+      chunk.set_data(blob.data() + offset,
+                     std::min<size_t>(chunk_size, blob.size() - offset));
+      if (!write(chunk)) return false;
+    }
+  }
+  return true;
+}
+
+absl::Status ChunkAssembler::Add(CallChunk chunk) {
+  if (!has_header_) {
+    if (chunk.content_case() != CallChunk::kRequest &&
+        chunk.content_case() != CallChunk::kResponse) {
+      return absl::InvalidArgumentError(
+          "First chunk must hold a request or a response.");
+    }
+    // The sizes are announced by the peer: check them before allocating.
+    int64_t total_size = 0;
+    for (int64_t size : chunk.blob_sizes()) {
+      if (size < 0) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Invalid blob size: ", size));
+      }
+      if (size > max_call_size_ - total_size) {
+        return absl::ResourceExhaustedError(absl::StrCat(
+            "Chunked call exceeds the maximum size of ", max_call_size_,
+            " bytes."));
+      }
+      total_size += size;
+    }
+    blob_sizes_.assign(chunk.blob_sizes().begin(), chunk.blob_sizes().end());
+    blobs_.resize(blob_sizes_.size());
+    for (size_t i = 0; i < blob_sizes_.size(); ++i) {
+      blobs_[i].reserve(blob_sizes_[i]);
+    }
+    chunk.clear_blob_sizes();
+    header_ = std::move(chunk);
+    has_header_ = true;
+    SkipCompleteBlobs();
+    return absl::OkStatus();
+  }
+
+  if (chunk.content_case() != CallChunk::kData) {
+    return absl::InvalidArgumentError("Unexpected chunk without data.");
+  }
+  if (complete()) {
+    return absl::InvalidArgumentError("Unexpected chunk after the last blob.");
+  }
+  std::string& blob = blobs_[current_];
+  if (blob.size() + chunk.data().size() > blob_sizes_[current_]) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Chunk exceeds the size of blob ", current_, "."));
+  }
+  blob.append(chunk.data());
+  SkipCompleteBlobs();
+  return absl::OkStatus();
+}
+
+bool ChunkAssembler::complete() const {
+  return has_header_ && current_ == blobs_.size();
+}
+
+absl::StatusOr<CallChunk> ChunkAssembler::Finish() {
+  COURIER_RET_CHECK(complete());
+  if (header_.has_request()) {
+    COURIER_RETURN_IF_ERROR(RestoreBlobs(
+        &blobs_, header_.mutable_request()->mutable_arguments()));
+  } else {
+    CallResult* result = header_.mutable_response()->mutable_result();
+    COURIER_RETURN_IF_ERROR(RestoreBlobs(&blobs_, result->mutable_result()));
+  }
+  blobs_.clear();
+  return std::move(header_);
+}
+
+void ChunkAssembler::SkipCompleteBlobs() {
+  while (current_ < blobs_.size() &&
+         blobs_[current_].size() == blob_sizes_[current_]) {
+    ++current_;
+  }
+}
+
+}  // namespace courier
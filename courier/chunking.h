@@ -0,0 +1,101 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_CHUNKING_H_
+#define COURIER_CHUNKING_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "courier/courier_service.pb.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+// Controls how calls are split by `CourierService.ChunkedCall`.
+struct ChunkingOptions {
+  // Bytes payloads of at least this size are moved out of the call and sent
+  // as separate chunks.
+  int64_t min_blob_size = 1 << 20;
+
+  // Maximum size of the data of a single chunk.
+  int64_t chunk_size = 4 << 20;
+
+  // Maximum total size of the payloads of a request or response received in
+  // chunks. Larger ones are rejected before any buffer is allocated.
+  int64_t max_call_size = int64_t{16} << 30;
+};
+
+// Moves all bytes payloads of at least `min_blob_size` bytes out of `object`
+// and appends them to `blobs`. The payloads are replaced by `BlobReference`s
+// holding their index in `blobs`. The payloads are moved, not copied.
+void ExtractBlobs(int64_t min_blob_size, SerializedObject* object,
+                  std::vector<std::string>* blobs);
+void ExtractBlobs(int64_t min_blob_size, CallArguments* arguments,
+                  std::vector<std::string>* blobs);
+
+// Inverse of `ExtractBlobs`. Moves the payloads out of `blobs`. Fails if a
+// payload is referenced more than once.
+absl::Status RestoreBlobs(std::vector<std::string>* blobs,
+                          SerializedObject* object);
+absl::Status RestoreBlobs(std::vector<std::string>* blobs,
+                          CallArguments* arguments);
+
+// Writes `header` followed by the content of `blobs` split in chunks of at
+// most `chunk_size` bytes. `header` must hold a request or a response whose
+// blob references point into `blobs`. Returns false as soon as `write` does.
+bool WriteChunks(const CallChunk& header, const std::vector<std::string>& blobs,
+                 int64_t chunk_size,
+                 const std::function<bool(const CallChunk&)>& write);
+
+// Reassembles a request or response from the messages of a `ChunkedCall`
+// stream. Payload buffers are allocated at their full size as soon as the
+// first message announces them, up to a total of `max_call_size` bytes.
+class ChunkAssembler {
+ public:
+  explicit ChunkAssembler(
+      int64_t max_call_size = ChunkingOptions().max_call_size)
+      : max_call_size_(max_call_size) {}
+
+  // Consumes the next message of the stream.
+  absl::Status Add(CallChunk chunk);
+
+  // Whether the first message and the content of all payloads it announced
+  // have been received.
+  bool complete() const;
+
+  // Returns the first message with all blob references resolved. Must only be
+  // called once, after `complete()` returned true.
+  absl::StatusOr<CallChunk> Finish();
+
+ private:
+  // Advances `current_` past all completely received payloads.
+  void SkipCompleteBlobs();
+
+  const int64_t max_call_size_;
+  bool has_header_ = false;
+  CallChunk header_;
+  std::vector<std::string> blobs_;
+  std::vector<int64_t> blob_sizes_;
+  // Index of the payload currently being received.
+  size_t current_ = 0;
+};
+
+}  // namespace courier
+
+#endif  // COURIER_CHUNKING_H_
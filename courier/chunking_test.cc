@@ -0,0 +1,62 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/chunking.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "courier/courier_service.pb.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+namespace {
+
+TEST(ChunkingTest, RestoresExtractedBlobs) {
+  CallArguments arguments;
+  arguments.add_args()->set_string_value(std::string(100, 'a'));
+  arguments.add_args()->set_string_value("small");
+  std::vector<std::string> blobs;
+  ExtractBlobs(/*min_blob_size=*/16, &arguments, &blobs);
+  ASSERT_EQ(blobs.size(), 1);
+  ASSERT_TRUE(arguments.args(0).has_blob_value());
+
+  ASSERT_TRUE(RestoreBlobs(&blobs, &arguments).ok());
+  EXPECT_EQ(arguments.args(0).string_value(), std::string(100, 'a'));
+  EXPECT_EQ(arguments.args(1).string_value(), "small");
+}
+
+TEST(ChunkingTest, RejectsBlobReferencedTwice) {
+  CallArguments arguments;
+  arguments.add_args()->mutable_blob_value()->set_index(0);
+  arguments.add_args()->mutable_blob_value()->set_index(0);
+  std::vector<std::string> blobs = {"payload"};
+  EXPECT_EQ(RestoreBlobs(&blobs, &arguments).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(ChunkingTest, RejectsAnnouncedSizesAboveMaximum) {
+  CallChunk chunk;
+  chunk.mutable_request()->set_method("method");
+  chunk.add_blob_sizes(60);
+  chunk.add_blob_sizes(60);
+  ChunkAssembler assembler(/*max_call_size=*/100);
+  EXPECT_EQ(assembler.Add(chunk).code(),
+            absl::StatusCode::kResourceExhausted);
+}
+
+}  // namespace
+}  // namespace courier
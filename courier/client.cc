@@ -14,6 +14,7 @@
 
 #include "courier/client.h"
 
+#include <algorithm>
 #include <functional>
 #include <iterator>
 #include <memory>
@@ -21,9 +22,9 @@
 #include <utility>
 #include <vector>
 
+#include "grpcpp/alarm.h"
 #include "grpcpp/channel.h"
 #include "grpcpp/client_context.h"
-#include "grpcpp/create_channel.h"
 #include "absl/functional/bind_front.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
@@ -34,8 +35,8 @@
 #include "absl/time/time.h"
 #include "courier/address_interceptor.h"
 #include "courier/call_context.h"
+#include "courier/chunking.h"
 #include "courier/courier_service.pb.h"
-#include "courier/platform/grpc_utils.h"
 #include "courier/platform/logging.h"
 #include "courier/platform/status_macros.h"
 #include "courier/serialization/serialization.pb.h"
@@ -65,61 +66,461 @@ bool IsRetryable(const absl::Status& status) {
   return absl::IsUnavailable(status);
 }
 
+// Full name of the `Call` RPC, for sending serialized requests.
+constexpr char kCallMethod[] = "/courier.CourierService/Call";
+
+// A replica failing with `Unavailable` is ejected for this long, doubling
+// with every consecutive failure up to `kMaxEjectionTime`.
+constexpr absl::Duration kMinEjectionTime = absl::Milliseconds(100);
+constexpr absl::Duration kMaxEjectionTime = absl::Seconds(10);
+
+namespace {
+
+// Runs a single attempt of a chunked call.
+absl::StatusOr<CallResult> RunChunkedCall(
+    /* grpc_gen:: */CourierService::Stub* stub, CallContext* context,
+    const CallChunk& header, const std::vector<std::string>& blobs,
+    const ChunkingOptions& options) {
+  std::unique_ptr<grpc::ClientReaderWriter<CallChunk, CallChunk>> stream(
+      stub->ChunkedCall(context->context()));
+  // On a failed write the stream is broken, `Finish` returns the reason.
+  if (WriteChunks(header, blobs, options.chunk_size,
+                  [&stream](const CallChunk& chunk) {
+                    return stream->Write(chunk);
+                  })) {
+    stream->WritesDone();
+  }
+
+  ChunkAssembler assembler(options.max_call_size);
+  CallChunk chunk;
+  while (stream->Read(&chunk)) {
+    absl::Status status = assembler.Add(std::move(chunk));
+    if (!status.ok()) {
+      context->context()->TryCancel();
+      stream->Finish();
+      return status;
+    }
+  }
+  COURIER_RETURN_IF_ERROR(FromGrpcStatus(stream->Finish()));
+  if (!assembler.complete()) {
+    return absl::InternalError("Stream ended before the result was complete.");
+  }
+  COURIER_ASSIGN_OR_RETURN(CallChunk response, assembler.Finish());
+  return std::move(*response.mutable_response()->mutable_result());
+}
+
+}  // namespace
+
 AsyncRequest::AsyncRequest(
-    Client* client, CallContext* context, MonitoredCallScope* monitor,
-    absl::string_view method_name, std::unique_ptr<CallArguments> arguments,
+    Client* client, Client::Connection* connection, CallContext* context,
+    MonitoredCallScope* monitor, absl::string_view method_name,
+    std::unique_ptr<CallArguments> arguments,
     std::function<void(absl::StatusOr<CallResult>)> callback)
     : client_(client),
+      connection_(connection),
       callback_(callback),
       context_(context),
       monitor_(monitor) {
   request_.set_method(std::string(method_name));
   request_.set_allocated_arguments(arguments.release());
+  if (client_->known_blobs_ != nullptr) {
+    ReplaceBlobsByDigest(client_->blob_cache_options_.min_blob_size,
+                         client_->known_blobs_.get(), &request_, &payloads_);
+  }
+  client_->AddPendingCall(context_);
+  connection_->num_calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+AsyncRequest::AsyncRequest(
+    Client* client, Client::Connection* connection, CallContext* context,
+    MonitoredCallScope* monitor, const SerializedCallRequest& request,
+    std::function<void(absl::StatusOr<CallResult>)> callback)
+    : client_(client),
+      connection_(connection),
+      callback_(std::move(callback)),
+      context_(context),
+      monitor_(monitor),
+      serialized_(true),
+      serialized_request_(request.buffer) {
+  client_->AddPendingCall(context_);
+  connection_->num_calls.fetch_add(1, std::memory_order_relaxed);
 }
 
 void AsyncRequest::Run() {
+  client_->PrepareAttempt(context_);
+  if (serialized_) {
+    std::unique_ptr<grpc::ClientAsyncResponseReader<grpc::ByteBuffer>> rpc(
+        connection_->generic_stub->PrepareUnaryCall(
+            context_->context(), kCallMethod, serialized_request_,
+            client_->cq_pool_->Next()));
+    rpc->StartCall();
+    rpc->Finish(&serialized_response_, &status_,
+                static_cast<CompletionQueueTag*>(this));
+    return;
+  }
   std::unique_ptr<grpc::ClientAsyncResponseReader<CallResponse>> rpc(
-      client_->stub_->PrepareAsyncCall(context_->context(), request_,
-                                       &client_->cq_));
+      connection_->stub->PrepareAsyncCall(context_->context(), request_,
+                                          client_->cq_pool_->Next()));
   rpc->StartCall();
-  rpc->Finish(&response_, &status_, (void*)this);
+  rpc->Finish(&response_, &status_, static_cast<CompletionQueueTag*>(this));
+}
+
+void AsyncRequest::Proceed(bool ok) {
+  if (retry_alarm_ != nullptr) {
+    // The backoff before the retry has elapsed, unless the call was cancelled
+    // or reached its deadline meanwhile.
+    absl::Status status = context_->RetryAlarmDone(ok);
+    retry_alarm_.reset();
+    if (status.ok()) {
+      Run();
+    } else {
+      Finish(status);
+    }
+    return;
+  }
+  COURIER_CHECK(ok);
+  if (serialized_ && status_.ok()) {
+    Done(grpc::SerializationTraits<CallResponse>::Deserialize(
+        &serialized_response_, &response_));
+    return;
+  }
+  Done(status_);
 }
 
 void AsyncRequest::Done(const ::grpc::Status& grpc_status) {
   absl::Status status = FromGrpcStatus(grpc_status);
-  if (IsRetryable(status) && context_->wait_for_ready()) {
+  if (status.ok() && response_.missing_blobs_size() > 0) {
+    // The server does not hold some of the payloads sent by digest.
+    status = AddMissingBlobs(response_, &payloads_, &request_);
+    if (status.ok()) {
+      response_.Clear();
+      context_->Reset();
+      Run();
+      return;
+    }
+  }
+  bool backoff;
+  Client::Connection* next =
+      client_->NextAttempt(context_, connection_, status, &backoff);
+  if (next != nullptr) {
     context_->Reset();
-    Run();
+    connection_->num_calls.fetch_sub(1, std::memory_order_relaxed);
+    connection_ = next;
+    connection_->num_calls.fetch_add(1, std::memory_order_relaxed);
+    if (!backoff) {
+      Run();
+      return;
+    }
+    // Set before scheduling, the alarm may fire on another thread right away.
+    retry_alarm_ = absl::make_unique<grpc::Alarm>();
+    client_->ScheduleRetry(context_, num_retries_++, retry_alarm_.get(), this);
   } else {
-    delete monitor_;
+    Finish(status);
+  }
+}
+
+void AsyncRequest::Finish(const absl::Status& status) {
+  delete monitor_;
+  client_->ReleaseContext(context_);
+  if (status.ok()) {
+    callback_(std::move(*response_.mutable_result()));
+  } else {
+    callback_(status);
+  }
+  connection_->num_calls.fetch_sub(1, std::memory_order_relaxed);
+  Client* client = client_;
+  delete this;
+  client->RemovePendingCall();
+}
+
+AsyncBatchRequest::AsyncBatchRequest(
+    Client* client, Client::Connection* connection, CallContext* context,
+    std::unique_ptr<BatchCallRequest> request,
+    std::function<void(absl::StatusOr<BatchCallResponse>)> callback)
+    : client_(client),
+      connection_(connection),
+      callback_(std::move(callback)),
+      context_(context),
+      request_(std::move(request)) {
+  client_->AddPendingCall(context_);
+  connection_->num_calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncBatchRequest::Run() {
+  client_->PrepareAttempt(context_);
+  std::unique_ptr<grpc::ClientAsyncResponseReader<BatchCallResponse>> rpc(
+      connection_->stub->PrepareAsyncBatchCall(context_->context(), *request_,
+                                               client_->cq_pool_->Next()));
+  rpc->StartCall();
+  rpc->Finish(&response_, &status_, static_cast<CompletionQueueTag*>(this));
+}
+
+void AsyncBatchRequest::Proceed(bool ok) {
+  if (retry_alarm_ != nullptr) {
+    // The backoff before the retry has elapsed, unless the call was cancelled
+    // or reached its deadline meanwhile.
+    absl::Status status = context_->RetryAlarmDone(ok);
+    retry_alarm_.reset();
     if (status.ok()) {
-      callback_(std::move(*response_.mutable_result()));
+      Run();
     } else {
-      callback_(status);
+      Finish(status);
+    }
+    return;
+  }
+  COURIER_CHECK(ok);
+  absl::Status status = FromGrpcStatus(status_);
+  bool backoff;
+  Client::Connection* next =
+      client_->NextAttempt(context_, connection_, status, &backoff);
+  if (next != nullptr) {
+    context_->Reset();
+    connection_->num_calls.fetch_sub(1, std::memory_order_relaxed);
+    connection_ = next;
+    connection_->num_calls.fetch_add(1, std::memory_order_relaxed);
+    if (!backoff) {
+      Run();
+      return;
+    }
+    // Set before scheduling, the alarm may fire on another thread right away.
+    retry_alarm_ = absl::make_unique<grpc::Alarm>();
+    client_->ScheduleRetry(context_, num_retries_++, retry_alarm_.get(), this);
+    return;
+  }
+  Finish(status);
+}
+
+void AsyncBatchRequest::Finish(const absl::Status& status) {
+  client_->ReleaseContext(context_);
+  if (status.ok()) {
+    callback_(std::move(response_));
+  } else {
+    callback_(status);
+  }
+  connection_->num_calls.fetch_sub(1, std::memory_order_relaxed);
+  Client* client = client_;
+  delete this;
+  client->RemovePendingCall();
+}
+
+HedgedCall::HedgedCall(
+    Client* client, CallContext* context, absl::string_view method_name,
+    std::unique_ptr<CallArguments> arguments,
+    std::function<void(absl::StatusOr<CallResult>)> callback)
+    : client_(client),
+      context_(context),
+      method_name_(method_name),
+      callback_(std::move(callback)),
+      start_time_(absl::Now()),
+      arguments_(std::move(arguments)) {
+  client_->AddPendingCall(context_);
+}
+
+void HedgedCall::Run() {
+  const absl::Duration delay = client_->hedging_->StartCall();
+  refs_ = 2;
+  CallContext* attempt;
+  std::unique_ptr<CallArguments> arguments;
+  {
+    absl::MutexLock lock(&mu_);
+    // The duplicate keeps the original arguments.
+    arguments = absl::make_unique<CallArguments>(*arguments_);
+    attempts_.push_back(context_->NewAttempt());
+    attempt = attempts_.back().get();
+    ++attempts_in_flight_;
+  }
+  alarm_.Set(client_->cq_pool_->Next(),
+             absl::ToChronoTime(absl::Now() + delay),
+             static_cast<void*>(static_cast<CompletionQueueTag*>(this)));
+  StartAttempt(attempt, std::move(arguments), /*is_hedge=*/false);
+}
+
+void HedgedCall::Proceed(bool ok) {
+  CallContext* attempt = nullptr;
+  std::unique_ptr<CallArguments> arguments;
+  {
+    absl::MutexLock lock(&mu_);
+    // `ok` is false if the alarm was cancelled as the call had completed.
+    if (ok && !done_ && client_->hedging_->TryHedge()) {
+      attempts_.push_back(context_->NewAttempt());
+      attempt = attempts_.back().get();
+      arguments = std::move(arguments_);
+      ++attempts_in_flight_;
+      ++refs_;
     }
-    delete this;
   }
+  if (attempt != nullptr) {
+    StartAttempt(attempt, std::move(arguments), /*is_hedge=*/true);
+  }
+  Unref();
 }
 
-void Client::cq_polling() {
-  void* tag;
-  bool ok = false;
-  while (cq_.Next(&tag, &ok)) {
-    AsyncRequest* request = static_cast<AsyncRequest*>(tag);
-    COURIER_CHECK(ok);
-    request->Done(request->status_);
+void HedgedCall::StartAttempt(CallContext* attempt,
+                              std::unique_ptr<CallArguments> arguments,
+                              bool is_hedge) {
+  client_->StartAsyncCall(
+      attempt, method_name_, std::move(arguments),
+      [this, is_hedge](absl::StatusOr<CallResult> result) {
+        AttemptDone(is_hedge, std::move(result));
+      });
+}
+
+void HedgedCall::AttemptDone(bool is_hedge,
+                             absl::StatusOr<CallResult> result) {
+  bool deliver;
+  {
+    absl::MutexLock lock(&mu_);
+    --attempts_in_flight_;
+    // An error only completes the call if no other attempt can succeed.
+    deliver = !done_ && (result.ok() || attempts_in_flight_ == 0);
+    if (deliver) {
+      done_ = true;
+      arguments_.reset();
+      for (const auto& attempt : attempts_) attempt->Cancel();
+      alarm_.Cancel();
+      // The caller may delete its context from the callback.
+      context_->ReleaseAttempts();
+    }
   }
+  if (deliver) {
+    client_->hedging_->FinishCall(absl::Now() - start_time_, is_hedge);
+    client_->ReleaseContext(context_);
+    callback_(std::move(result));
+  }
+  Unref();
+}
+
+void HedgedCall::Unref() {
+  if (refs_.fetch_sub(1) != 1) return;
+  Client* client = client_;
+  delete this;
+  client->RemovePendingCall();
 }
 
-Client::Client(absl::string_view server_address) :
-      cq_thread_(&Client::cq_polling, this),
-      server_address_(server_address) {
+Client::Client(absl::string_view server_address, int num_polling_threads,
+               int num_channels, const RetryPolicy& retry_policy)
+    : Client(std::vector<std::string>{std::string(server_address)},
+             num_polling_threads, num_channels, retry_policy) {}
+
+Client::Client(std::vector<std::string> server_addresses,
+               int num_polling_threads, int num_channels,
+               const RetryPolicy& retry_policy)
+    : server_addresses_(std::move(server_addresses)),
+      num_channels_(std::max(num_channels, 1)),
+      retry_controller_(retry_policy) {
+  if (num_polling_threads > 0) {
+    own_cq_pool_ = absl::make_unique<CompletionQueuePool>(num_polling_threads);
+    cq_pool_ = own_cq_pool_.get();
+  } else {
+    cq_pool_ = ClientRuntime::Get().cq_pool();
+  }
   ClientCreation();
 }
 
 Client::~Client() {
-  cq_.Shutdown();
-  cq_thread_.join();
+  absl::MutexLock lock(&pending_mu_);
+  // Calls retrying against an unreachable server would never complete.
+  for (const auto& item : pending_contexts_) item.first->Cancel();
+  pending_mu_.Await(absl::Condition(
+      +[](int* pending_calls) { return *pending_calls == 0; },
+      &pending_calls_));
+}
+
+void Client::AddPendingCall(CallContext* context) {
+  absl::MutexLock lock(&pending_mu_);
+  ++pending_calls_;
+  ++pending_contexts_[context];
+}
+
+void Client::ReleaseContext(CallContext* context) {
+  absl::MutexLock lock(&pending_mu_);
+  auto it = pending_contexts_.find(context);
+  if (it != pending_contexts_.end() && --it->second == 0) {
+    pending_contexts_.erase(it);
+  }
+}
+
+void Client::RemovePendingCall() {
+  absl::MutexLock lock(&pending_mu_);
+  --pending_calls_;
+}
+
+void Client::EnableHedging(const HedgingPolicy& policy) {
+  hedging_ = absl::make_unique<HedgingController>(policy);
+}
+
+void Client::EnableBlobCache(const BlobCacheOptions& options) {
+  blob_cache_options_ = options;
+  known_blobs_ = absl::make_unique<BlobCache>(options.max_bytes);
+}
+
+void Client::ScheduleRetry(CallContext* context, int num_retries,
+                           grpc::Alarm* alarm, CompletionQueueTag* tag) {
+  context->SetRetryAlarm(retry_controller_.NextRetryDelay(num_retries), alarm,
+                         cq_pool_->Next(), static_cast<void*>(tag));
+}
+
+Client::Connection* Client::PickConnection() {
+  const int num_connections = connections_.size();
+  if (num_connections == 1) return connections_.front().get();
+  const int start = next_connection_.fetch_add(1, std::memory_order_relaxed) %
+                    num_connections;
+  const int64_t now = replicated() ? absl::ToUnixNanos(absl::Now()) : 0;
+  Connection* best = nullptr;
+  int best_num_calls = 0;
+  Connection* first_back = nullptr;
+  int64_t first_back_time = 0;
+  for (int i = 0; i < num_connections; ++i) {
+    Connection* connection = connections_[(start + i) % num_connections].get();
+    const int64_t ejected_until =
+        connection->ejected_until.load(std::memory_order_relaxed);
+    if (ejected_until > now) {
+      if (first_back == nullptr || ejected_until < first_back_time) {
+        first_back = connection;
+        first_back_time = ejected_until;
+      }
+      continue;
+    }
+    const int num_calls = connection->num_calls.load(std::memory_order_relaxed);
+    if (best == nullptr || num_calls < best_num_calls) {
+      best = connection;
+      best_num_calls = num_calls;
+    }
+  }
+  return best != nullptr ? best : first_back;
+}
+
+void Client::PrepareAttempt(CallContext* context) {
+  if (replicated()) context->context()->set_wait_for_ready(false);
+}
+
+Client::Connection* Client::NextAttempt(CallContext* context,
+                                        Connection* connection,
+                                        const absl::Status& status,
+                                        bool* backoff) {
+  if (replicated()) {
+    if (IsRetryable(status)) {
+      const int num_failures =
+          connection->num_failures.fetch_add(1, std::memory_order_relaxed);
+      const absl::Duration ejection_time =
+          std::min(kMinEjectionTime * (1 << std::min(num_failures, 8)),
+                   kMaxEjectionTime);
+      connection->ejected_until.store(
+          absl::ToUnixNanos(absl::Now() + ejection_time),
+          std::memory_order_relaxed);
+    } else if (connection->num_failures.load(std::memory_order_relaxed) > 0) {
+      connection->num_failures.store(0, std::memory_order_relaxed);
+      connection->ejected_until.store(0, std::memory_order_relaxed);
+    }
+  }
+  if (!IsRetryable(status)) return nullptr;
+
+  Connection* next = PickConnection();
+  *backoff = !replicated() ||
+             next->ejected_until.load(std::memory_order_relaxed) >
+                 absl::ToUnixNanos(absl::Now());
+  if (*backoff && !context->wait_for_ready()) return nullptr;
+  return next;
 }
 
 absl::StatusOr<courier::CallResult> Client::CallF(
@@ -130,78 +531,269 @@ absl::StatusOr<courier::CallResult> Client::CallF(
   CallRequest request;
   request.set_method(std::string(method_name));
   request.set_allocated_arguments(arguments.release());
-  COURIER_CHECK(stub_);
+  absl::flat_hash_map<std::string, std::string> payloads;
+  if (known_blobs_ != nullptr) {
+    ReplaceBlobsByDigest(blob_cache_options_.min_blob_size,
+                         known_blobs_.get(), &request, &payloads);
+  }
+  Connection* connection = PickConnection();
   CallResponse response;
 
-  auto monitor =
-      BuildCallMonitor(channel_.get(), request.method(), server_address_);
-  while (true) {
-    absl::Status status =
-        FromGrpcStatus(stub_->Call(context->context(), request, &response));
+  auto monitor = BuildCallMonitor(connection->channel.get(), request.method(),
+                                  connection->address);
+  for (int num_retries = 0;;) {
+    absl::Status status;
+    {
+      ConnectionScope connection_scope(connection);
+      PrepareAttempt(context);
+      status = FromGrpcStatus(
+          connection->stub->Call(context->context(), request, &response));
+    }
+    if (status.ok() && response.missing_blobs_size() > 0) {
+      // The server does not hold some of the payloads sent by digest.
+      COURIER_RETURN_IF_ERROR(AddMissingBlobs(response, &payloads, &request));
+      response.Clear();
+      context->Reset();
+      continue;
+    }
 
-    if (!IsRetryable(status) || !context->wait_for_ready()) {
+    bool backoff;
+    Connection* next = NextAttempt(context, connection, status, &backoff);
+    if (next == nullptr) {
       COURIER_RETURN_IF_ERROR(status);
       break;
     }
     context->Reset();
+    if (backoff) {
+      COURIER_RETURN_IF_ERROR(context->WaitForRetry(
+          retry_controller_.NextRetryDelay(num_retries++)));
+    }
+    connection = next;
   }
   return std::move(response).result();
 }
 
+absl::StatusOr<courier::CallResult> Client::ChunkedCallF(
+    CallContext* context, absl::string_view method_name,
+    std::unique_ptr<courier::CallArguments> arguments,
+    const ChunkingOptions& options) {
+  COURIER_RETURN_IF_ERROR(TryInit(context));
+
+  CallChunk header;
+  CallRequest* request = header.mutable_request();
+  request->set_method(std::string(method_name));
+  request->set_allocated_arguments(arguments.release());
+  std::vector<std::string> blobs;
+  ExtractBlobs(options.min_blob_size, request->mutable_arguments(), &blobs);
+  Connection* connection = PickConnection();
+
+  auto monitor = BuildCallMonitor(connection->channel.get(), request->method(),
+                                  connection->address);
+  for (int num_retries = 0;;) {
+    absl::StatusOr<CallResult> result;
+    {
+      ConnectionScope connection_scope(connection);
+      PrepareAttempt(context);
+      result = RunChunkedCall(connection->stub.get(), context, header, blobs,
+                              options);
+    }
+
+    bool backoff;
+    Connection* next =
+        NextAttempt(context, connection, result.status(), &backoff);
+    if (next == nullptr) return result;
+    context->Reset();
+    if (backoff) {
+      COURIER_RETURN_IF_ERROR(context->WaitForRetry(
+          retry_controller_.NextRetryDelay(num_retries++)));
+    }
+    connection = next;
+  }
+}
+
 void Client::AsyncCallF(
     CallContext* context, absl::string_view method_name,
     std::unique_ptr<courier::CallArguments> arguments,
     std::function<void(absl::StatusOr<courier::CallResult>)> callback) {
+  if (hedging_ != nullptr && hedging_->IsHedged(method_name)) {
+    // Call deletes itself upon completion.
+    HedgedCall* call =
+        new HedgedCall(this, context, method_name, std::move(arguments),
+                       std::move(callback));
+    call->Run();
+    return;
+  }
+  StartAsyncCall(context, method_name, std::move(arguments),
+                 std::move(callback));
+}
+
+void Client::StartAsyncCall(
+    CallContext* context, absl::string_view method_name,
+    std::unique_ptr<courier::CallArguments> arguments,
+    std::function<void(absl::StatusOr<courier::CallResult>)> callback) {
   absl::Status status = TryInit(context);
   if (!status.ok()) {
     callback(status);
     return;
   }
 
-  COURIER_CHECK(stub_);
-  auto monitor = BuildCallMonitor(channel_.get(), std::string(method_name),
-                                  server_address_);
+  Connection* connection = PickConnection();
+  auto monitor = BuildCallMonitor(connection->channel.get(),
+                                  std::string(method_name),
+                                  connection->address);
   // Request deletes itself upon completion.
   AsyncRequest* request =
-      new AsyncRequest(this, context, monitor.release(), method_name,
-                       std::move(arguments), callback);
+      new AsyncRequest(this, connection, context, monitor.release(),
+                       method_name, std::move(arguments), callback);
   request->Run();
 }
 
+absl::StatusOr<SerializedCallRequest> Client::SerializeCallRequest(
+    absl::string_view method_name,
+    std::unique_ptr<courier::CallArguments> arguments) {
+  CallRequest request;
+  request.set_method(std::string(method_name));
+  request.set_allocated_arguments(arguments.release());
+  SerializedCallRequest serialized;
+  serialized.method_name = std::string(method_name);
+  bool own_buffer;
+  COURIER_RETURN_IF_ERROR(
+      FromGrpcStatus(grpc::SerializationTraits<CallRequest>::Serialize(
+          request, &serialized.buffer, &own_buffer)));
+  return serialized;
+}
+
+void Client::AsyncSerializedCallF(
+    CallContext* context, const SerializedCallRequest& request,
+    std::function<void(absl::StatusOr<courier::CallResult>)> callback) {
+  absl::Status status = TryInit(context);
+  if (!status.ok()) {
+    callback(status);
+    return;
+  }
+
+  Connection* connection = PickConnection();
+  auto monitor = BuildCallMonitor(connection->channel.get(),
+                                  request.method_name, connection->address);
+  // Request deletes itself upon completion.
+  AsyncRequest* async_request =
+      new AsyncRequest(this, connection, context, monitor.release(), request,
+                       std::move(callback));
+  async_request->Run();
+}
+
+void Client::AsyncBatchCallF(
+    CallContext* context, std::unique_ptr<BatchCallRequest> request,
+    std::function<void(absl::StatusOr<BatchCallResponse>)> callback) {
+  absl::Status status = TryInit(context);
+  if (!status.ok()) {
+    callback(status);
+    return;
+  }
+
+  // Request deletes itself upon completion.
+  AsyncBatchRequest* batch_request = new AsyncBatchRequest(
+      this, PickConnection(), context, std::move(request), std::move(callback));
+  batch_request->Run();
+}
+
 absl::StatusOr<std::vector<std::string>> Client::ListMethods() {
   CallContext context;
   COURIER_RETURN_IF_ERROR(TryInit(&context));
-  COURIER_CHECK(stub_);
   ListMethodsRequest request;
   ListMethodsResponse response;
-  COURIER_RETURN_IF_ERROR(FromGrpcStatus(
-      stub_->ListMethods(context.context(), request, &response)));
+  COURIER_RETURN_IF_ERROR(FromGrpcStatus(PickConnection()->stub->ListMethods(
+      context.context(), request, &response)));
   return std::vector<std::string>(
       std::make_move_iterator(response.mutable_methods()->begin()),
       std::make_move_iterator(response.mutable_methods()->end()));
 }
 
+std::unique_ptr<Subscription> Client::Subscribe(absl::string_view topic,
+                                                int64_t last_version,
+                                                bool wait_for_ready) {
+  return absl::make_unique<Subscription>(this, topic, last_version,
+                                         wait_for_ready);
+}
+
+Subscription::Subscription(Client* client, absl::string_view topic,
+                           int64_t last_version, bool wait_for_ready)
+    : client_(client),
+      topic_(topic),
+      last_version_(last_version),
+      context_(absl::ZeroDuration(), wait_for_ready) {}
+
+Subscription::~Subscription() {
+  if (stream_ != nullptr) {
+    context_.Cancel();
+    stream_->Finish();
+  }
+}
+
+absl::StatusOr<SubscribeResponse> Subscription::Next() {
+  while (true) {
+    if (stream_ == nullptr) {
+      COURIER_RETURN_IF_ERROR(client_->TryInit(&context_));
+      if (connection_ == nullptr) connection_ = client_->PickConnection();
+      client_->PrepareAttempt(&context_);
+      SubscribeRequest request;
+      request.set_topic(topic_);
+      request.set_last_version(last_version_);
+      stream_ = connection_->stub->Subscribe(context_.context(), request);
+    }
+
+    SubscribeResponse response;
+    if (stream_->Read(&response)) {
+      last_version_ = response.version();
+      num_retries_ = 0;
+      return response;
+    }
+    absl::Status status = FromGrpcStatus(stream_->Finish());
+    stream_.reset();
+    if (status.ok()) {
+      status = absl::UnavailableError("Subscription stream ended.");
+    }
+    bool backoff;
+    connection_ =
+        client_->NextAttempt(&context_, connection_, status, &backoff);
+    if (connection_ == nullptr) return status;
+    context_.Reset();
+    if (backoff) {
+      COURIER_RETURN_IF_ERROR(context_.WaitForRetry(
+          client_->retry_controller_.NextRetryDelay(num_retries_++)));
+    }
+  }
+}
+
 absl::Status Client::TryInit(CallContext* context) {
   {
     absl::ReaderMutexLock lock(&init_mu_);
-    if (stub_) return absl::OkStatus();
+    if (!connections_.empty()) return absl::OkStatus();
   }
   absl::WriterMutexLock lock(&init_mu_);
-  if (stub_) return absl::OkStatus();
+  if (!connections_.empty()) return absl::OkStatus();
 
-  std::string address;
-  if (!InterceptorSingleton().GetRedirect(server_address_, &address)) {
-    address = server_address_;
+  std::vector<std::unique_ptr<Connection>> connections;
+  connections.reserve(server_addresses_.size() * num_channels_);
+  // Channels are interleaved across replicas so that ties between idle
+  // connections are broken across replicas first.
+  for (int i = 0; i < num_channels_; ++i) {
+    for (const std::string& server_address : server_addresses_) {
+      std::string address;
+      if (!InterceptorSingleton().GetRedirect(server_address, &address)) {
+        address = server_address;
+      }
+      auto connection = absl::make_unique<Connection>();
+      connection->address = server_address;
+      connection->channel = ClientRuntime::Get().GetChannel(address, i);
+      connection->stub =
+          /* grpc_gen:: */CourierService::NewStub(connection->channel);
+      connection->generic_stub =
+          absl::make_unique<grpc::GenericStub>(connection->channel);
+      connections.push_back(std::move(connection));
+    }
   }
-
-  grpc::ChannelArguments channel_args;
-  channel_args.SetInt(GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH, -1);
-  channel_args.SetInt(GRPC_ARG_MAX_SEND_MESSAGE_LENGTH, -1);
-  channel_args.SetInt(GRPC_ARG_MAX_METADATA_SIZE, 16 * 1024 * 1024);
-
-  channel_ =
-      CreateCustomGrpcChannel(address, MakeChannelCredentials(), channel_args);
-  stub_ = /* grpc_gen:: */CourierService::NewStub(channel_);
+  connections_ = std::move(connections);
 
   return absl::OkStatus();
 }
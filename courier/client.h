@@ -15,42 +15,89 @@
 #ifndef COURIER_CLIENT_H_
 #define COURIER_CLIENT_H_
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <future>  // NOLINT
 #include <memory>
 #include <string>
-#include <thread>  // NOLINT
 #include <tuple>
 #include <utility>
 #include <vector>
 
+#include "grpcpp/alarm.h"
+#include "grpcpp/generic/generic_stub.h"
 #include "grpcpp/grpcpp.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "courier/blob_cache.h"
 #include "courier/call_context.h"
+#include "courier/chunking.h"
+#include "courier/client_runtime.h"
+#include "courier/completion_queue_pool.h"
 #include "courier/courier_service.grpc.pb.h"
 #include "courier/courier_service.pb.h"
+#include "courier/hedging.h"
 #include "courier/platform/client_monitor.h"
 #include "courier/platform/status_macros.h"
+#include "courier/retry_policy.h"
 #include "courier/serialization/serialization.pb.h"
 #include "courier/serialization/serialize.h"
 
 namespace courier {
 
+class AsyncBatchRequest;
+class HedgedCall;
+class Subscription;
+
+// A call request serialized once, to be sent to several servers without
+// encoding it again. Copies share the underlying buffer.
+struct SerializedCallRequest {
+  std::string method_name;
+  grpc::ByteBuffer buffer;
+};
+
 // Client implements the client-side of the Courier RPC setup. It is used
 // to call methods on a server. All member functions are thread-safe.
 //
-// Please note that the calls do not have any timeout or retry policy.
+// Please note that the calls do not have any timeout by default. Calls made
+// with `CallContext::wait_for_ready` are retried with the backoff of the
+// client's `RetryPolicy` while the server is unavailable.
 //
 class Client {
  public:
-  // Creates a new Client that will connect to a Server.
-  explicit Client(absl::string_view server_address);
+  // Creates a new Client that will connect to a Server. By default the client
+  // uses the process-wide `ClientRuntime`: completions of asynchronous calls
+  // are processed by its shared polling threads and the channel is shared
+  // with all other clients of the same address. A positive
+  // `num_polling_threads` gives the client its own pool of polling threads
+  // instead. With `num_channels` > 1 calls are spread over that many
+  // connections to the server, each call going to the channel with the fewest
+  // calls in flight. `retry_policy` controls the backoff between the retries
+  // of calls made with `CallContext::wait_for_ready`.
+  explicit Client(absl::string_view server_address,
+                  int num_polling_threads = 0, int num_channels = 1,
+                  const RetryPolicy& retry_policy = RetryPolicy());
 
+  // Creates a client of a replicated service, each of `server_addresses`
+  // serving the same methods. Every call goes to the replica with the fewest
+  // calls in flight. A replica failing with `Unavailable` is ejected: it gets
+  // no calls for a while and the failed call moves to another replica right
+  // away, regardless of `CallContext::wait_for_ready`. Calls only back off
+  // and wait for a replica once all of them are ejected.
+  explicit Client(std::vector<std::string> server_addresses,
+                  int num_polling_threads = 0, int num_channels = 1,
+                  const RetryPolicy& retry_policy = RetryPolicy());
+
+  // Cancels the pending asynchronous calls and blocks until they have
+  // completed, which they do promptly once cancelled.
   ~Client();
 
   // Calls a method on the server. The caller retains ownership of `context`.
@@ -61,15 +108,46 @@ class Client {
       CallContext* context, absl::string_view method_name,
       std::unique_ptr<courier::CallArguments> arguments);
 
+  // Same as `CallF` but transfers large arguments and results in bounded
+  // chunks over a streaming RPC. Required for payloads exceeding the 2GB
+  // protobuf message size limit; also avoids materializing them as a single
+  // message on either end.
+  absl::StatusOr<courier::CallResult> ChunkedCallF(
+      CallContext* context, absl::string_view method_name,
+      std::unique_ptr<courier::CallArguments> arguments,
+      const ChunkingOptions& options = ChunkingOptions());
+
   // Calls a method on the server asynchronously. The caller retains ownership
   // of `context` which must not be deleted before `callback` is invoked. If
   // `CallContext::wait_for_ready` is true, then `Unavailable` errors are
-  // automatically retried.
+  // automatically retried. Calls of the methods of the `HedgingPolicy` are
+  // hedged, see `EnableHedging`.
   void AsyncCallF(
       CallContext* context, absl::string_view method_name,
       std::unique_ptr<courier::CallArguments> arguments,
       std::function<void(absl::StatusOr<courier::CallResult>)> callback);
 
+  // Serializes the request of a call for `AsyncSerializedCallF`.
+  static absl::StatusOr<SerializedCallRequest> SerializeCallRequest(
+      absl::string_view method_name,
+      std::unique_ptr<courier::CallArguments> arguments);
+
+  // Same as `AsyncCallF` with a request serialized by `SerializeCallRequest`,
+  // which is shared with the call rather than copied. See `AsyncBroadcastF`
+  // for sending the same call to several servers.
+  void AsyncSerializedCallF(
+      CallContext* context, const SerializedCallRequest& request,
+      std::function<void(absl::StatusOr<courier::CallResult>)> callback);
+
+  // Executes several calls in a single RPC. `callback` receives the outcomes
+  // of the individual calls, or the error which made the whole RPC fail. The
+  // caller retains ownership of `context` which must not be deleted before
+  // `callback` is invoked. See `CallBatcher` for batching calls
+  // automatically.
+  void AsyncBatchCallF(
+      CallContext* context, std::unique_ptr<BatchCallRequest> request,
+      std::function<void(absl::StatusOr<BatchCallResponse>)> callback);
+
   // Calls a method on the server. The variadic arguments will be serialized
   // and the result from calling the method on the server will be deserialized
   // to the expected type. If `CallContext::wait_for_ready` is true, then
@@ -80,19 +158,166 @@ class Client {
     auto arguments = absl::make_unique<courier::CallArguments>();
     COURIER_RETURN_IF_ERROR(SerializeToRepeatedObject(
         std::forward_as_tuple(args...), arguments->mutable_args()));
-    COURIER_ASSIGN_OR_RETURN(courier::CallResult result_proto,
-                             CallF(context, method, std::move(arguments)));
-    R result;
-    COURIER_RETURN_IF_ERROR(
-        DeserializeFromObject(result_proto.result(), &result));
-    return result;
+    return DeserializeCallResult<R>(
+        CallF(context, method, std::move(arguments)));
+  }
+
+  // Asynchronous variant of `Call`. `callback` is invoked with the
+  // deserialized result on a completion queue polling thread, so it must not
+  // block. The caller retains ownership of `context` which must not be
+  // deleted before `callback` is invoked.
+  template <typename R, typename... Args>
+  void AsyncCall(CallContext* context, absl::string_view method,
+                 std::function<void(absl::StatusOr<R>)> callback,
+                 const Args&... args) {
+    auto arguments = absl::make_unique<courier::CallArguments>();
+    absl::Status status = SerializeToRepeatedObject(
+        std::forward_as_tuple(args...), arguments->mutable_args());
+    if (!status.ok()) {
+      callback(status);
+      return;
+    }
+    AsyncCallF(context, method, std::move(arguments),
+               [callback = std::move(callback)](
+                   absl::StatusOr<courier::CallResult> result) {
+                 callback(DeserializeCallResult<R>(std::move(result)));
+               });
+  }
+
+  // Same as `AsyncCall` but the result is returned through a future. The
+  // caller retains ownership of `context` which must not be deleted before
+  // the future is ready.
+  template <typename R, typename... Args>
+  std::future<absl::StatusOr<R>> AsyncCallFuture(CallContext* context,
+                                                 absl::string_view method,
+                                                 const Args&... args) {
+    auto promise = std::make_shared<std::promise<absl::StatusOr<R>>>();
+    std::future<absl::StatusOr<R>> future = promise->get_future();
+    AsyncCall<R>(
+        context, method,
+        [promise](absl::StatusOr<R> result) {
+          promise->set_value(std::move(result));
+        },
+        args...);
+    return future;
+  }
+
+  // Calls a method once for each element of `arguments` and returns the
+  // results in the same order. All calls are in flight at the same time, each
+  // with its own `CallContext` created from `timeout` and `wait_for_ready`.
+  // Blocks until all calls have completed, so it must not be invoked from the
+  // callback of an asynchronous call.
+  template <typename R, typename... Args>
+  std::vector<absl::StatusOr<R>> CallMany(
+      absl::string_view method,
+      const std::vector<std::tuple<Args...>>& arguments,
+      absl::Duration timeout = absl::ZeroDuration(),
+      bool wait_for_ready = true) {
+    std::vector<absl::StatusOr<R>> results(arguments.size());
+    std::vector<std::unique_ptr<CallContext>> contexts;
+    contexts.reserve(arguments.size());
+    absl::BlockingCounter pending(arguments.size());
+    for (size_t i = 0; i < arguments.size(); ++i) {
+      contexts.push_back(absl::make_unique<CallContext>(timeout,
+                                                        wait_for_ready));
+      auto call_arguments = absl::make_unique<courier::CallArguments>();
+      absl::Status status = SerializeToRepeatedObject(
+          arguments[i], call_arguments->mutable_args());
+      if (!status.ok()) {
+        results[i] = status;
+        pending.DecrementCount();
+        continue;
+      }
+      AsyncCallF(contexts.back().get(), method, std::move(call_arguments),
+                 [result = &results[i], &pending](
+                     absl::StatusOr<courier::CallResult> call_result) {
+                   *result = DeserializeCallResult<R>(std::move(call_result));
+                   pending.DecrementCount();
+                 });
+    }
+    pending.Wait();
+    return results;
   }
 
   // Lists the methods available on the server.
   absl::StatusOr<std::vector<std::string>> ListMethods();
 
+  // Subscribes to the versions of the value the server publishes under
+  // `topic`, skipping `last_version`. The client must outlive the
+  // subscription.
+  std::unique_ptr<Subscription> Subscribe(absl::string_view topic,
+                                          int64_t last_version = 0,
+                                          bool wait_for_ready = true);
+
+  // Returns the number of retries made by the calls of the client.
+  RetryStats retry_stats() const { return retry_controller_.stats(); }
+
+  // Hedges the asynchronous calls of the methods of `policy`: a call still in
+  // flight after the hedging delay is duplicated, preferably to another
+  // replica, and the first response wins. Must be called before the first
+  // call.
+  void EnableHedging(const HedgingPolicy& policy);
+
+  // Returns the hedging counters, all zero if hedging is disabled.
+  HedgingStats hedging_stats() const {
+    return hedging_ ? hedging_->stats() : HedgingStats();
+  }
+
+  // Sends the large arguments of `CallF` and `AsyncCallF` calls by digest
+  // once the server holds them, see `BlobCacheOptions`. Must be called before
+  // the first call.
+  void EnableBlobCache(const BlobCacheOptions& options);
+
  private:
   friend class AsyncRequest;
+  friend class AsyncBatchRequest;
+  friend class HedgedCall;
+  friend class Subscription;
+
+  // Deserializes the result of a call to the expected type.
+  template <typename R>
+  static absl::StatusOr<R> DeserializeCallResult(
+      absl::StatusOr<courier::CallResult> call_result) {
+    COURIER_RETURN_IF_ERROR(call_result.status());
+    R result;
+    COURIER_RETURN_IF_ERROR(
+        DeserializeFromObject(call_result->result(), &result));
+    return result;
+  }
+
+  // A channel of the client together with its stub.
+  struct Connection {
+    // Address of the replica, as passed to the constructor.
+    std::string address;
+    std::shared_ptr<grpc::ChannelInterface> channel;
+    std::unique_ptr</* grpc_gen:: */CourierService::Stub> stub;
+    // Sends requests which are already serialized.
+    std::unique_ptr<grpc::GenericStub> generic_stub;
+    // Number of calls currently in flight on the channel.
+    std::atomic<int> num_calls{0};
+    // Number of consecutive calls which failed with `Unavailable` and the
+    // time, in Unix nanoseconds, until which the connection is ejected.
+    std::atomic<int> num_failures{0};
+    std::atomic<int64_t> ejected_until{0};
+  };
+
+  // Marks a call as in flight on a connection for the lifetime of the scope.
+  class ConnectionScope {
+   public:
+    explicit ConnectionScope(Connection* connection)
+        : connection_(connection) {
+      connection_->num_calls.fetch_add(1, std::memory_order_relaxed);
+    }
+    ~ConnectionScope() {
+      connection_->num_calls.fetch_sub(1, std::memory_order_relaxed);
+    }
+    ConnectionScope(const ConnectionScope&) = delete;
+    ConnectionScope& operator=(const ConnectionScope&) = delete;
+
+   private:
+    Connection* connection_;
+  };
+
   // Initializes the stub RPC client. This has to be called outside of the
   // constructor as it might block and we expect the constructor to be non
   // blocking. If the singleton `AddressInterceptor` was enabled, then we
@@ -100,43 +325,224 @@ class Client {
   // `server_address` to create the stub.
   absl::Status TryInit(CallContext* context) ABSL_LOCKS_EXCLUDED(init_mu_);
 
-  // Run by dedicated thread it polls on the competion queue.
-  void cq_polling();
+  // Same as `AsyncCallF` but without hedging.
+  void StartAsyncCall(
+      CallContext* context, absl::string_view method_name,
+      std::unique_ptr<courier::CallArguments> arguments,
+      std::function<void(absl::StatusOr<courier::CallResult>)> callback);
+
+  // Called by `AsyncRequest` when it starts and when it has completed.
+  // `context` is cancelled if the client is destroyed in between, until
+  // `ReleaseContext` is called right before the callback of the call, which
+  // may destroy the context.
+  void AddPendingCall(CallContext* context) ABSL_LOCKS_EXCLUDED(pending_mu_);
+  void ReleaseContext(CallContext* context) ABSL_LOCKS_EXCLUDED(pending_mu_);
+  void RemovePendingCall() ABSL_LOCKS_EXCLUDED(pending_mu_);
+
+  // Notifies `tag` through `alarm` once the backoff before the retry of an
+  // asynchronous call has elapsed, see `CallContext::SetRetryAlarm`.
+  // `num_retries` is the number of retries the call has made so far.
+  void ScheduleRetry(CallContext* context, int num_retries, grpc::Alarm* alarm,
+                     CompletionQueueTag* tag);
+
+  // Returns the connection with the fewest calls in flight among those which
+  // are not ejected, or the one whose ejection ends first if all are. Ties
+  // are broken in round-robin order. Must only be called after a successful
+  // `TryInit`.
+  Connection* PickConnection();
 
-  grpc::CompletionQueue cq_;
-  std::thread cq_thread_;
+  // Whether the client has more than one replica to spread its calls over.
+  bool replicated() const { return server_addresses_.size() > 1; }
+
+  // Must be called before each attempt of a call. Attempts on replicas fail
+  // fast so that a down replica can be ejected instead of holding the call.
+  void PrepareAttempt(CallContext* context);
+
+  // Called once an attempt of a call on `connection` has completed with
+  // `status`. Returns the connection on which to retry the call, or null if
+  // the call is done. `backoff` is set if the retry has to wait first, which
+  // is the case when no replica is left to fail over to.
+  Connection* NextAttempt(CallContext* context, Connection* connection,
+                          const absl::Status& status, bool* backoff);
 
   // Ensures initialization is only done once.
   absl::Mutex init_mu_;
 
-  // Stored for logging.
-  const std::string server_address_;
+  // Number of asynchronous calls which have not completed yet.
+  absl::Mutex pending_mu_;
+  int pending_calls_ ABSL_GUARDED_BY(pending_mu_) = 0;
+  // Contexts of the pending calls, with the number of calls using each.
+  absl::flat_hash_map<CallContext*, int> pending_contexts_
+      ABSL_GUARDED_BY(pending_mu_);
+
+  const std::vector<std::string> server_addresses_;
+
+  const int num_channels_;
+
+  RetryController retry_controller_;
+
+  // Set by `EnableHedging`.
+  std::unique_ptr<HedgingController> hedging_;
 
-  // The RPC client channel and stub.
-  std::shared_ptr<grpc::ChannelInterface> channel_;
-  std::unique_ptr</* grpc_gen:: */CourierService::Stub> stub_;
+  // Set by `EnableBlobCache`. Digests of the payloads the server is assumed
+  // to hold.
+  BlobCacheOptions blob_cache_options_;
+  std::unique_ptr<BlobCache> known_blobs_;
+
+  // The RPC client channels and stubs. Set once by `TryInit`.
+  std::vector<std::unique_ptr<Connection>> connections_;
+  std::atomic<uint64_t> next_connection_{0};
+
+  // Set if the client has its own polling threads. Declared last so that
+  // pending asynchronous calls complete before the stub is destroyed.
+  std::unique_ptr<CompletionQueuePool> own_cq_pool_;
+
+  // Either `own_cq_pool_` or the pool of the `ClientRuntime`.
+  CompletionQueuePool* cq_pool_;
 };
 
-class AsyncRequest {
+class AsyncRequest : public CompletionQueueTag {
  public:
-  AsyncRequest(Client* client, CallContext* context,
-               MonitoredCallScope* monitor, absl::string_view method_name,
+  AsyncRequest(Client* client, Client::Connection* connection,
+               CallContext* context, MonitoredCallScope* monitor,
+               absl::string_view method_name,
                std::unique_ptr<CallArguments> arguments,
                std::function<void(absl::StatusOr<CallResult>)> callback);
 
+  // Sends a request which is already serialized.
+  AsyncRequest(Client* client, Client::Connection* connection,
+               CallContext* context, MonitoredCallScope* monitor,
+               const SerializedCallRequest& request,
+               std::function<void(absl::StatusOr<CallResult>)> callback);
+
   void Run();
 
+  void Proceed(bool ok) override;
+
   void Done(const ::grpc::Status& grpc_status);
 
  private:
   friend class Client;
+
+  // Completes the call with the result in `response_` if `status` is OK, and
+  // deletes this.
+  void Finish(const absl::Status& status);
+
   Client* client_;
+  Client::Connection* connection_;
   const std::function<void(absl::StatusOr<courier::CallResult>)> callback_;
   CallContext* context_;
   courier::CallRequest request_;
   courier::CallResponse response_;
   courier::MonitoredCallScope* monitor_;
   grpc::Status status_;
+  // Set instead of `request_` for requests which are already serialized.
+  bool serialized_ = false;
+  grpc::ByteBuffer serialized_request_;
+  grpc::ByteBuffer serialized_response_;
+  // Payloads sent by digest, kept in case the server does not hold them.
+  absl::flat_hash_map<std::string, std::string> payloads_;
+  int num_retries_ = 0;
+  // Set while waiting for the backoff before a retry.
+  std::unique_ptr<grpc::Alarm> retry_alarm_;
+};
+
+class AsyncBatchRequest : public CompletionQueueTag {
+ public:
+  AsyncBatchRequest(
+      Client* client, Client::Connection* connection, CallContext* context,
+      std::unique_ptr<BatchCallRequest> request,
+      std::function<void(absl::StatusOr<BatchCallResponse>)> callback);
+
+  void Run();
+
+  void Proceed(bool ok) override;
+
+ private:
+  // Completes the call with `response_` if `status` is OK, and deletes this.
+  void Finish(const absl::Status& status);
+
+  Client* client_;
+  Client::Connection* connection_;
+  const std::function<void(absl::StatusOr<BatchCallResponse>)> callback_;
+  CallContext* context_;
+  std::unique_ptr<BatchCallRequest> request_;
+  BatchCallResponse response_;
+  grpc::Status status_;
+  int num_retries_ = 0;
+  // Set while waiting for the backoff before a retry.
+  std::unique_ptr<grpc::Alarm> retry_alarm_;
+};
+
+// A call of a hedged method, see `Client::EnableHedging`. The call and its
+// duplicate run on attempts of the caller's context. Deletes itself once
+// both of them and the hedging timer have completed.
+class HedgedCall : public CompletionQueueTag {
+ public:
+  HedgedCall(Client* client, CallContext* context,
+             absl::string_view method_name,
+             std::unique_ptr<CallArguments> arguments,
+             std::function<void(absl::StatusOr<CallResult>)> callback);
+
+  void Run() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Invoked once the hedging delay has elapsed.
+  void Proceed(bool ok) override ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  void StartAttempt(CallContext* attempt,
+                    std::unique_ptr<CallArguments> arguments, bool is_hedge);
+
+  void AttemptDone(bool is_hedge, absl::StatusOr<CallResult> result)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  void Unref();
+
+  Client* const client_;
+  CallContext* const context_;
+  const std::string method_name_;
+  const std::function<void(absl::StatusOr<courier::CallResult>)> callback_;
+  const absl::Time start_time_;
+  grpc::Alarm alarm_;
+  // Number of attempts in flight plus one for the pending alarm.
+  std::atomic<int> refs_{0};
+
+  absl::Mutex mu_;
+  // Arguments of the duplicate, until it is sent.
+  std::unique_ptr<CallArguments> arguments_ ABSL_GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<CallContext>> attempts_ ABSL_GUARDED_BY(mu_);
+  int attempts_in_flight_ ABSL_GUARDED_BY(mu_) = 0;
+  // Set once `callback_` has been invoked.
+  bool done_ ABSL_GUARDED_BY(mu_) = false;
+};
+
+// Stream of the versions of a value published by a server, see `Publisher`.
+// Reading returns the latest version at that time: versions published in
+// between two reads are skipped.
+class Subscription {
+ public:
+  Subscription(Client* client, absl::string_view topic, int64_t last_version,
+               bool wait_for_ready);
+  ~Subscription();
+
+  // Blocks until a version other than the last one returned is published and
+  // returns it. If the server becomes unavailable and `wait_for_ready` is
+  // set, subscribes again, possibly to another replica. Returns `Cancelled`
+  // once `Cancel` has been called. Must not be called concurrently.
+  absl::StatusOr<SubscribeResponse> Next();
+
+  // Ends the subscription, unblocking `Next`. Thread-safe.
+  void Cancel() { context_.Cancel(); }
+
+ private:
+  Client* const client_;
+  const std::string topic_;
+  int64_t last_version_;
+  CallContext context_;
+  // Connection of the current or of the next stream.
+  Client::Connection* connection_ = nullptr;
+  std::unique_ptr<grpc::ClientReader<SubscribeResponse>> stream_;
+  int num_retries_ = 0;
 };
 }  // namespace courier
 
@@ -0,0 +1,160 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// C++20 coroutine support for `Client`. Only this header requires C++20, the
+// rest of Courier builds with C++14 and later.
+//
+// Example:
+//   absl::StatusOr<int> result =
+//       co_await CoCall<int>(&client, &context, "please_add", 4, 7);
+
+#ifndef COURIER_CLIENT_COROUTINE_H_
+#define COURIER_CLIENT_COROUTINE_H_
+
+#include <version>
+
+#if !defined(__cpp_impl_coroutine) || !defined(__cpp_lib_jthread)
+#error "courier/client_coroutine.h requires C++20."
+#endif
+
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "courier/call_context.h"
+#include "courier/client.h"
+#include "courier/courier_service.pb.h"
+#include "courier/serialization/serialize.h"
+
+namespace courier {
+
+// Runs the continuation of a coroutine, e.g. by scheduling it on a thread
+// pool.
+using CoroutineExecutor = std::function<void(std::function<void()>)>;
+
+// Awaitable of a call made with `CoCall`. Awaiting it yields the deserialized
+// result of the call. Its state lives on the heap, so the awaitable may be
+// moved freely before it is awaited.
+template <typename R>
+class CallAwaitable {
+ public:
+  CallAwaitable(Client* client, CallContext* context, absl::string_view method,
+                absl::StatusOr<std::unique_ptr<CallArguments>> arguments)
+      : state_(absl::make_unique<State>()) {
+    state_->client = client;
+    state_->context = context;
+    state_->method = std::string(method);
+    state_->arguments = std::move(arguments);
+  }
+
+  // Resumes the awaiting coroutine through `executor` rather than on the
+  // completion queue polling thread of the client.
+  CallAwaitable&& ResumeOn(CoroutineExecutor executor) && {
+    state_->executor = std::move(executor);
+    return std::move(*this);
+  }
+
+  // Cancels the call, through `CallContext::Cancel`, once a stop is requested
+  // on `stop_token`.
+  CallAwaitable&& StopOn(std::stop_token stop_token) && {
+    state_->stop_token = std::move(stop_token);
+    return std::move(*this);
+  }
+
+  // Completes immediately if the arguments could not be serialized.
+  bool await_ready() const noexcept { return !state_->arguments.ok(); }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    State* state = state_.get();
+    if (state->stop_token.stop_possible()) {
+      state->stop_callback.emplace(state->stop_token,
+                                   Canceller{state->context});
+    }
+    state->client->AsyncCallF(
+        state->context, state->method, std::move(state->arguments).value(),
+        [state, handle](absl::StatusOr<CallResult> call_result) {
+          state->result = Deserialize(std::move(call_result));
+          // Blocks until a concurrently running `Canceller` has returned.
+          state->stop_callback.reset();
+          if (state->executor) {
+            state->executor([handle] { handle.resume(); });
+          } else {
+            handle.resume();
+          }
+        });
+  }
+
+  absl::StatusOr<R> await_resume() {
+    if (!state_->arguments.ok()) return state_->arguments.status();
+    return std::move(state_->result);
+  }
+
+ private:
+  struct Canceller {
+    CallContext* context;
+    void operator()() const { context->Cancel(); }
+  };
+
+  struct State {
+    Client* client;
+    CallContext* context;
+    std::string method;
+    absl::StatusOr<std::unique_ptr<CallArguments>> arguments;
+    CoroutineExecutor executor;
+    std::stop_token stop_token;
+    std::optional<std::stop_callback<Canceller>> stop_callback;
+    absl::StatusOr<R> result;
+  };
+
+  static absl::StatusOr<R> Deserialize(
+      absl::StatusOr<CallResult> call_result) {
+    if (!call_result.ok()) return call_result.status();
+    R result;
+    absl::Status status = DeserializeFromObject(call_result->result(), &result);
+    if (!status.ok()) return status;
+    return result;
+  }
+
+  std::unique_ptr<State> state_;
+};
+
+// Calls a method on the server from a coroutine. The variadic arguments are
+// serialized and the call starts once the returned awaitable is awaited. By
+// default the coroutine is resumed on a completion queue polling thread of
+// the client, so it should hand off any blocking work. The caller retains
+// ownership of `context` which must outlive the `co_await`.
+template <typename R, typename... Args>
+CallAwaitable<R> CoCall(Client* client, CallContext* context,
+                        absl::string_view method, const Args&... args) {
+  auto arguments = absl::make_unique<CallArguments>();
+  absl::Status status = SerializeToRepeatedObject(
+      std::forward_as_tuple(args...), arguments->mutable_args());
+  if (!status.ok()) {
+    return CallAwaitable<R>(client, context, method, status);
+  }
+  return CallAwaitable<R>(client, context, method, std::move(arguments));
+}
+
+}  // namespace courier
+
+#endif  // COURIER_CLIENT_COROUTINE_H_
@@ -0,0 +1,120 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/client_coroutine.h"
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "courier/call_context.h"
+#include "courier/client.h"
+#include "courier/handlers/interface.h"
+#include "courier/platform/status_macros.h"
+#include "courier/router.h"
+#include "courier/serialization/serialization.pb.h"
+#include "courier/serialization/serialize.h"
+#include "courier/server.h"
+#include "test/core/util/port.h"
+
+namespace courier {
+namespace {
+
+class AddHandler : public HandlerInterface {
+ public:
+  absl::StatusOr<CallResult> Call(absl::string_view endpoint,
+                                  const CallArguments& arguments) override {
+    if (arguments.args_size() != 2) {
+      return absl::InvalidArgumentError("Expected two arguments.");
+    }
+    int64_t a, b;
+    COURIER_RETURN_IF_ERROR(DeserializeFromObject(arguments.args(0), &a));
+    COURIER_RETURN_IF_ERROR(DeserializeFromObject(arguments.args(1), &b));
+    CallResult result;
+    COURIER_RETURN_IF_ERROR(SerializeToObject(a + b, result.mutable_result()));
+    return result;
+  }
+};
+
+// Coroutine which runs to completion on its own.
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+DetachedTask CallAdd(Client* client, CallContext* context,
+                     absl::string_view method,
+                     absl::StatusOr<int64_t>* result,
+                     absl::Notification* done) {
+  *result = co_await CoCall<int64_t>(client, context, method, int64_t{4},
+                                     int64_t{7});
+  done->Notify();
+}
+
+class ClientCoroutineTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(router_.Bind("add", std::make_shared<AddHandler>()).ok());
+    int port = grpc_pick_unused_port_or_die();
+    auto server = Server::BuildAndStart(&router_, port);
+    ASSERT_TRUE(server.ok()) << server.status();
+    server_ = std::move(server).value();
+    client_ = std::make_unique<Client>(absl::StrCat("localhost:", port));
+  }
+
+  void TearDown() override {
+    client_.reset();
+    if (server_ != nullptr) {
+      ASSERT_TRUE(server_->Stop().ok());
+    }
+  }
+
+  Router router_;
+  std::unique_ptr<Server> server_;
+  std::unique_ptr<Client> client_;
+};
+
+TEST_F(ClientCoroutineTest, AwaitsResult) {
+  CallContext context;
+  absl::StatusOr<int64_t> result;
+  absl::Notification done;
+  CallAdd(client_.get(), &context, "add", &result, &done);
+  done.WaitForNotification();
+  ASSERT_TRUE(result.ok()) << result.status();
+  EXPECT_EQ(*result, 11);
+}
+
+TEST_F(ClientCoroutineTest, AwaitsError) {
+  CallContext context;
+  absl::StatusOr<int64_t> result;
+  absl::Notification done;
+  CallAdd(client_.get(), &context, "missing", &result, &done);
+  done.WaitForNotification();
+  EXPECT_EQ(result.status().code(), absl::StatusCode::kNotFound);
+}
+
+}  // namespace
+}  // namespace courier
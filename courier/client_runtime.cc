@@ -0,0 +1,74 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/client_runtime.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "grpcpp/grpcpp.h"
+#include "absl/flags/flag.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "courier/platform/grpc_utils.h"
+
+ABSL_FLAG(int, courier_client_polling_threads, 4,
+          "Number of completion queue polling threads shared by all Courier "
+          "clients of the process.");
+
+namespace courier {
+
+ClientRuntime& ClientRuntime::Get() {
+  // Never destroyed, clients may outlive static destruction.
+  static auto* runtime =
+      new ClientRuntime(absl::GetFlag(FLAGS_courier_client_polling_threads));
+  return *runtime;
+}
+
+ClientRuntime::ClientRuntime(int num_polling_threads)
+    : cq_pool_(num_polling_threads) {}
+
+std::shared_ptr<grpc::ChannelInterface> ClientRuntime::GetChannel(
+    absl::string_view address, int index) {
+  const std::pair<std::string, int> key(address, index);
+  absl::MutexLock lock(&mu_);
+  auto it = channels_.find(key);
+  if (it != channels_.end()) {
+    if (auto channel = it->second.lock()) return channel;
+  }
+
+  // Drop the entries of channels which are no longer used.
+  for (it = channels_.begin(); it != channels_.end();) {
+    auto current = it++;
+    if (current->second.expired()) channels_.erase(current);
+  }
+
+  grpc::ChannelArguments channel_args;
+  channel_args.SetInt(GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH, -1);
+  channel_args.SetInt(GRPC_ARG_MAX_SEND_MESSAGE_LENGTH, -1);
+  channel_args.SetInt(GRPC_ARG_MAX_METADATA_SIZE, 16 * 1024 * 1024);
+  if (index != 0) {
+    // Channels with equal arguments would otherwise share their subchannels
+    // through the global subchannel pool, and with it a single connection.
+    channel_args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    channel_args.SetInt("courier.channel_index", index);
+  }
+  auto channel = CreateCustomGrpcChannel(address, MakeChannelCredentials(),
+                                         channel_args);
+  channels_[key] = channel;
+  return channel;
+}
+
+}  // namespace courier
@@ -0,0 +1,64 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_CLIENT_RUNTIME_H_
+#define COURIER_CLIENT_RUNTIME_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "grpcpp/grpcpp.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "courier/completion_queue_pool.h"
+
+namespace courier {
+
+// Resources shared by all `Client`s of a process: a pool of completion queue
+// polling threads and a cache of channels keyed by address. This bounds the
+// number of threads and connections regardless of how many clients exist.
+// Thread-safe.
+class ClientRuntime {
+ public:
+  // Returns the process-wide runtime. Its size is set by the
+  // `courier_client_polling_threads` flag on first use.
+  static ClientRuntime& Get();
+
+  explicit ClientRuntime(int num_polling_threads);
+
+  CompletionQueuePool* cq_pool() { return &cq_pool_; }
+
+  // Returns a channel to `address`. Callers asking for the same `address` and
+  // `index` share a single channel for as long as any of them holds on to it.
+  // Channels of different non-zero `index` use their own subchannels, hence
+  // their own connections, which lets a client spread its calls over several
+  // connections to the same server.
+  std::shared_ptr<grpc::ChannelInterface> GetChannel(absl::string_view address,
+                                                     int index = 0);
+
+ private:
+  CompletionQueuePool cq_pool_;
+
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::pair<std::string, int>,
+                      std::weak_ptr<grpc::ChannelInterface>>
+      channels_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace courier
+
+#endif  // COURIER_CLIENT_RUNTIME_H_
@@ -0,0 +1,59 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/completion_queue_pool.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>  // NOLINT
+
+#include "grpcpp/grpcpp.h"
+#include "absl/memory/memory.h"
+
+namespace courier {
+
+CompletionQueuePool::CompletionQueuePool(int num_threads) {
+  num_threads = std::max(num_threads, 1);
+  queues_.reserve(num_threads);
+  threads_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    queues_.push_back(absl::make_unique<grpc::CompletionQueue>());
+    threads_.emplace_back(&CompletionQueuePool::Poll, queues_.back().get());
+  }
+}
+
+CompletionQueuePool::~CompletionQueuePool() {
+  for (auto& queue : queues_) {
+    queue->Shutdown();
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+grpc::CompletionQueue* CompletionQueuePool::Next() {
+  return queues_[next_.fetch_add(1, std::memory_order_relaxed) %
+                 queues_.size()]
+      .get();
+}
+
+void CompletionQueuePool::Poll(grpc::CompletionQueue* cq) {
+  void* tag;
+  bool ok = false;
+  while (cq->Next(&tag, &ok)) {
+    static_cast<CompletionQueueTag*>(tag)->Proceed(ok);
+  }
+}
+
+}  // namespace courier
@@ -0,0 +1,67 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_COMPLETION_QUEUE_POOL_H_
+#define COURIER_COMPLETION_QUEUE_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "grpcpp/grpcpp.h"
+
+namespace courier {
+
+// Tag of the asynchronous operations started on the completion queues of a
+// `CompletionQueuePool`.
+class CompletionQueueTag {
+ public:
+  virtual ~CompletionQueueTag() = default;
+
+  // Invoked on a polling thread once the operation has completed. `ok` is the
+  // status reported by `grpc::CompletionQueue::Next`.
+  virtual void Proceed(bool ok) = 0;
+};
+
+// A set of completion queues, each drained by a dedicated polling thread.
+// Operations are spread over the queues so that completions are not limited
+// by the throughput of a single thread. All tags must be
+// `CompletionQueueTag`s. Thread-safe.
+class CompletionQueuePool {
+ public:
+  // Starts `num_threads` (at least one) queues and their polling threads.
+  explicit CompletionQueuePool(int num_threads);
+
+  // Shuts the queues down and joins the polling threads once all pending
+  // operations have completed.
+  ~CompletionQueuePool();
+
+  // Returns the queue to use for the next operation, in round-robin order.
+  grpc::CompletionQueue* Next();
+
+  int size() const { return queues_.size(); }
+
+ private:
+  static void Poll(grpc::CompletionQueue* cq);
+
+  std::vector<std::unique_ptr<grpc::CompletionQueue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<uint64_t> next_{0};
+};
+
+}  // namespace courier
+
+#endif  // COURIER_COMPLETION_QUEUE_POOL_H_
@@ -0,0 +1,57 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/handlers/coalescing.h"
+
+#include <memory>
+#include <string>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
+#include "courier/serialization/call_key.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+absl::StatusOr<CallResult> CoalescingHandler::Call(
+    absl::string_view endpoint, const CallArguments& arguments) {
+  absl::optional<std::string> key = CallKey(endpoint, arguments);
+  if (!key.has_value()) return handler_->Call(endpoint, arguments);
+  std::shared_ptr<Flight> flight;
+  bool leader = false;
+  {
+    absl::MutexLock lock(&mu_);
+    std::shared_ptr<Flight>& slot = flights_[*key];
+    if (slot == nullptr) {
+      slot = std::make_shared<Flight>();
+      leader = true;
+    }
+    flight = slot;
+  }
+  if (!leader) {
+    flight->done.WaitForNotification();
+    return flight->result;
+  }
+  flight->result = handler_->Call(endpoint, arguments);
+  {
+    absl::MutexLock lock(&mu_);
+    flights_.erase(*key);
+  }
+  flight->done.Notify();
+  return flight->result;
+}
+
+}  // namespace courier
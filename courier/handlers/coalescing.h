@@ -0,0 +1,65 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_HANDLERS_COALESCING_H_
+#define COURIER_HANDLERS_COALESCING_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "courier/handlers/interface.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+// Wraps a handler such that concurrent calls with the same method name and
+// byte-identical arguments share a single execution of `handler` and its
+// result. A call arriving after that execution completed executes `handler`
+// again. Calls with arguments above `kMaxKeyedArgumentsSize` bytes are not
+// coalesced. Only meant for methods without side effects, such as getters of
+// the latest parameters polled by many clients at once.
+class CoalescingHandler : public HandlerInterface {
+ public:
+  explicit CoalescingHandler(std::shared_ptr<HandlerInterface> handler)
+      : handler_(std::move(handler)) {}
+
+  absl::StatusOr<CallResult> Call(absl::string_view endpoint,
+                                  const CallArguments& arguments) override
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // An execution of `handler_` shared by concurrent calls.
+  struct Flight {
+    absl::Notification done;
+    absl::StatusOr<CallResult> result;
+  };
+
+  const std::shared_ptr<HandlerInterface> handler_;
+
+  absl::Mutex mu_;
+  // Executions in progress, keyed by `CallKey`.
+  absl::flat_hash_map<std::string, std::shared_ptr<Flight>> flights_
+      ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace courier
+
+#endif  // COURIER_HANDLERS_COALESCING_H_
@@ -16,8 +16,11 @@
 
 #include <pybind11/pybind11.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "courier/platform/default/py_utils.h"
 #include "absl/base/casts.h"
@@ -26,6 +29,9 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "courier/handlers/interface.h"
 #include "courier/platform/logging.h"
 #include "courier/platform/status_macros.h"
@@ -66,9 +72,47 @@ absl::StatusCode PythonExceptionErrorCode() {
   return absl::StatusCode::kUnknown;
 }
 
+// Returns the status describing the pending Python exception. Requires the
+// GIL.
+absl::Status PythonExceptionStatus() {
+  std::string error_prefix = "Python exception was raised on the server";
+  absl::StatusCode status_code = PythonExceptionErrorCode();
+  std::string exception;
+  if (PythonUtils::FetchPendingException(&exception)) {
+    std::string error_message = absl::StrCat(error_prefix, ":\n", exception);
+    COURIER_LOG(COURIER_ERROR) << error_message;
+    return absl::Status(status_code, error_message);
+  }
+  return absl::InternalError(absl::StrCat(
+      error_prefix, " but the exception message could not be caught.   "));
+}
+
+// Deserializes the arguments of a call into a tuple of positional arguments
+// and a dict of keyword arguments. Requires the GIL.
+absl::Status DeserializeArguments(const courier::CallArguments& arguments,
+                                  TensorLookup* lookup,
+                                  courier::SafePyObjectPtr* py_args,
+                                  courier::SafePyObjectPtr* py_kwargs) {
+  py_args->reset(PyTuple_New(arguments.args_size()));
+  for (int i = 0; i < arguments.args_size(); i++) {
+    COURIER_ASSIGN_OR_RETURN(courier::SafePyObjectPtr py_arg,
+                             DeserializePyObject(arguments.args(i), *lookup));
+    PyTuple_SET_ITEM(py_args->get(), i, py_arg.release());
+  }
+
+  py_kwargs->reset(PyDict_New());
+  for (const auto& pair : arguments.kwargs()) {
+    COURIER_ASSIGN_OR_RETURN(courier::SafePyObjectPtr py_value,
+                             DeserializePyObject(pair.second, *lookup));
+    PyDict_SetItemString(py_kwargs->get(), pair.first.data(), py_value.get());
+  }
+  return absl::OkStatus();
+}
+
 class PyCallHandler : public HandlerInterface {
  public:
-  explicit PyCallHandler(PyObject* py_func) : py_func_(py_func) {
+  PyCallHandler(PyObject* py_func, const SerializationOptions& options)
+      : py_func_(py_func), options_(options) {
     Py_INCREF(py_func_);
   }
 
@@ -86,53 +130,185 @@ class PyCallHandler : public HandlerInterface {
 
     pybind11::gil_scoped_acquire gil;
 
-    // Deserialize args.
-    courier::SafePyObjectPtr py_args(PyTuple_New(arguments.args_size()));
-    for (int i = 0; i < arguments.args_size(); i++) {
-      COURIER_ASSIGN_OR_RETURN(courier::SafePyObjectPtr py_arg,
-                               DeserializePyObject(arguments.args(i), lookup));
-      PyTuple_SET_ITEM(py_args.get(), i, py_arg.release());
-    }
-
-    // Deserialize kwargs.
-    courier::SafePyObjectPtr py_kwargs(PyDict_New());
-    for (const auto& pair : arguments.kwargs()) {
-      COURIER_ASSIGN_OR_RETURN(courier::SafePyObjectPtr py_value,
-                               DeserializePyObject(pair.second, lookup));
-      PyDict_SetItemString(py_kwargs.get(), pair.first.data(), py_value.get());
-    }
+    courier::SafePyObjectPtr py_args;
+    courier::SafePyObjectPtr py_kwargs;
+    COURIER_RETURN_IF_ERROR(
+        DeserializeArguments(arguments, &lookup, &py_args, &py_kwargs));
 
     courier::SafePyObjectPtr py_result(
         PyObject_Call(py_func_, py_args.get(), py_kwargs.get()));
 
     if (py_result) {
       courier::CallResult result;
-      COURIER_RETURN_IF_ERROR(
-          SerializePyObject(py_result.get(), result.mutable_result()));
+      COURIER_RETURN_IF_ERROR(SerializePyObject(
+          py_result.get(), result.mutable_result(), options_));
       return result;
     } else {
-      std::string error_prefix = "Python exception was raised on the server";
-      absl::StatusCode status_code = PythonExceptionErrorCode();
-      std::string exception;
-      if (PythonUtils::FetchPendingException(&exception)) {
-        std::string error_message =
-            absl::StrCat(error_prefix, ":\n", exception);
-        COURIER_LOG(COURIER_ERROR) << error_message;
-        return absl::Status(status_code, error_message);
-      }
-      return absl::InternalError(absl::StrCat(
-          error_prefix, " but the exception message could not be caught.   "));
+      return PythonExceptionStatus();
     }
   }
 
  private:
   PyObject* py_func_;
+  const SerializationOptions options_;
+};
+
+// Gathers concurrent calls and executes them with a single invocation of the
+// Python callable. The thread of one of the waiting calls leads the next
+// batch: it waits for the batch to fill up or for its oldest call to reach
+// `max_latency`, then executes the batch on behalf of all its calls.
+class BatchedPyCallHandler : public HandlerInterface {
+ public:
+  BatchedPyCallHandler(PyObject* py_func, int max_batch_size,
+                       absl::Duration max_latency,
+                       const SerializationOptions& options)
+      : py_func_(py_func),
+        max_batch_size_(std::max(max_batch_size, 1)),
+        max_latency_(max_latency),
+        options_(options) {
+    Py_INCREF(py_func_);
+  }
+
+  ~BatchedPyCallHandler() override {
+    pybind11::gil_scoped_acquire gil;
+    Py_DECREF(py_func_);
+  }
+
+  absl::StatusOr<courier::CallResult> Call(
+      absl::string_view endpoint,
+      const courier::CallArguments& arguments) override {
+    PendingCall call;
+    call.arguments = &arguments;
+    call.enqueue_time = absl::Now();
+
+    absl::MutexLock lock(&mu_);
+    queue_.push_back(&call);
+    auto done_or_leaderless = [this, &call]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+                                  mu_) { return call.done || !leader_active_; };
+    while (true) {
+      mu_.Await(absl::Condition(&done_or_leaderless));
+      if (call.done) return std::move(call.result);
+
+      // Lead the next batch, which may or may not include this call.
+      leader_active_ = true;
+      mu_.AwaitWithDeadline(absl::Condition(this, &BatchedPyCallHandler::Full),
+                            queue_.front()->enqueue_time + max_latency_);
+      const int batch_size = std::min<int>(queue_.size(), max_batch_size_);
+      std::vector<PendingCall*> batch(queue_.begin(),
+                                      queue_.begin() + batch_size);
+      queue_.erase(queue_.begin(), queue_.begin() + batch_size);
+
+      mu_.Unlock();
+      RunBatch(batch);
+      mu_.Lock();
+
+      for (PendingCall* done : batch) done->done = true;
+      leader_active_ = false;
+    }
+  }
+
+ private:
+  struct PendingCall {
+    const courier::CallArguments* arguments;
+    absl::Time enqueue_time;
+    absl::StatusOr<courier::CallResult> result;
+    // Set by the leader of the batch once `result` is available.
+    bool done = false;
+  };
+
+  bool Full() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queue_.size() >= max_batch_size_;
+  }
+
+  // Executes a batch and sets the results of its calls.
+  void RunBatch(const std::vector<PendingCall*>& batch) {
+    // Converting TensorProto to Tensor does not require the GIL.
+    std::vector<absl::StatusOr<TensorLookup>> lookups;
+    lookups.reserve(batch.size());
+    for (PendingCall* call : batch) {
+      lookups.push_back(CreateTensorLookup(*call->arguments));
+    }
+
+    pybind11::gil_scoped_acquire gil;
+
+    // Calls whose arguments could be deserialized, in order.
+    std::vector<PendingCall*> calls;
+    courier::SafePyObjectPtr py_calls(PyList_New(0));
+    for (int i = 0; i < batch.size(); ++i) {
+      if (!lookups[i].ok()) {
+        batch[i]->result = lookups[i].status();
+        continue;
+      }
+      courier::SafePyObjectPtr py_args;
+      courier::SafePyObjectPtr py_kwargs;
+      absl::Status status = DeserializeArguments(
+          *batch[i]->arguments, &lookups[i].value(), &py_args, &py_kwargs);
+      if (!status.ok()) {
+        batch[i]->result = status;
+        continue;
+      }
+      courier::SafePyObjectPtr py_call(
+          PyTuple_Pack(2, py_args.get(), py_kwargs.get()));
+      PyList_Append(py_calls.get(), py_call.get());
+      calls.push_back(batch[i]);
+    }
+    if (calls.empty()) return;
+
+    courier::SafePyObjectPtr py_results(
+        PyObject_CallFunctionObjArgs(py_func_, py_calls.get(), nullptr));
+    if (!py_results) {
+      absl::Status status = PythonExceptionStatus();
+      for (PendingCall* call : calls) call->result = status;
+      return;
+    }
+    courier::SafePyObjectPtr py_results_list(
+        PySequence_Fast(py_results.get(), "Results must be a sequence."));
+    if (!py_results_list ||
+        PySequence_Fast_GET_SIZE(py_results_list.get()) != calls.size()) {
+      PyErr_Clear();
+      absl::Status status = absl::InternalError(absl::StrCat(
+          "Batched function must return a sequence of ", calls.size(),
+          " results."));
+      for (PendingCall* call : calls) call->result = status;
+      return;
+    }
+    for (int i = 0; i < calls.size(); ++i) {
+      courier::CallResult result;
+      absl::Status status = SerializePyObject(
+          PySequence_Fast_GET_ITEM(py_results_list.get(), i),
+          result.mutable_result(), options_);
+      if (status.ok()) {
+        calls[i]->result = std::move(result);
+      } else {
+        calls[i]->result = status;
+      }
+    }
+  }
+
+  PyObject* py_func_;
+  const int max_batch_size_;
+  const absl::Duration max_latency_;
+  const SerializationOptions options_;
+
+  absl::Mutex mu_;
+  // Calls waiting for a batch, in arrival order.
+  std::vector<PendingCall*> queue_ ABSL_GUARDED_BY(mu_);
+  // Whether a thread is leading the next batch.
+  bool leader_active_ ABSL_GUARDED_BY(mu_) = false;
 };
 
 }  // namespace
 
-std::unique_ptr<HandlerInterface> BuildPyCallHandler(PyObject* py_func) {
-  return absl::make_unique<PyCallHandler>(py_func);
+std::unique_ptr<HandlerInterface> BuildPyCallHandler(
+    PyObject* py_func, const SerializationOptions& options) {
+  return absl::make_unique<PyCallHandler>(py_func, options);
+}
+
+std::unique_ptr<HandlerInterface> BuildPyBatchedCallHandler(
+    PyObject* py_func, int max_batch_size, absl::Duration max_latency,
+    const SerializationOptions& options) {
+  return absl::make_unique<BatchedPyCallHandler>(py_func, max_batch_size,
+                                                 max_latency, options);
 }
 
 }  // namespace courier
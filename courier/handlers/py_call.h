@@ -17,7 +17,9 @@
 
 #include <memory>
 
+#include "absl/time/time.h"
 #include "courier/handlers/interface.h"
+#include "courier/serialization/py_serialize.h"
 #include <pybind11/pybind11.h>
 
 namespace courier {
@@ -28,8 +30,21 @@ namespace courier {
 // function is blocking but can be scheduled asynchronously via the provided
 // `executor`. Note that this handler acquires the GIL when running the
 // `py_func`. Any Python errors are converted to absl::Status and returned to
-// the caller.
-std::unique_ptr<HandlerInterface> BuildPyCallHandler(PyObject* py_func);
+// the caller. Results are serialized using `options`.
+std::unique_ptr<HandlerInterface> BuildPyCallHandler(
+    PyObject* py_func,
+    const SerializationOptions& options = SerializationOptions());
+
+// A method handler that executes concurrent calls with a single invocation of
+// a Python callable, e.g. to evaluate a model on a batch of inputs. Calls are
+// gathered until `max_batch_size` of them are waiting or the oldest one has
+// waited for `max_latency`. `py_func` receives a list with an
+// `(args, kwargs)` tuple per call and must return a sequence holding the
+// result of every call, in order. Arguments which fail to deserialize only
+// fail their own call, a Python exception fails the whole batch.
+std::unique_ptr<HandlerInterface> BuildPyBatchedCallHandler(
+    PyObject* py_func, int max_batch_size, absl::Duration max_latency,
+    const SerializationOptions& options = SerializationOptions());
 
 }  // namespace courier
 
@@ -16,6 +16,7 @@
 #include <pybind11/pytypes.h>
 
 #include <memory>
+#include <string>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
@@ -23,8 +24,11 @@
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "courier/handlers/coalescing.h"
 #include "courier/handlers/interface.h"
 #include "courier/handlers/py_call.h"
+#include "courier/serialization/array_encoding.h"
 
 #include "courier/serialization/py_serialize.h"
 #include "courier/serialization/serialization.pb.h"
@@ -39,10 +43,32 @@ namespace py = pybind11;
 
 namespace {
 
-std::shared_ptr<HandlerInterface> BuildPyCallHandlerWrapper(
-    py::handle& handle) {
+absl::StatusOr<std::shared_ptr<HandlerInterface>> BuildPyCallHandlerWrapper(
+    py::handle& handle, const std::string& float_encoding,
+    const std::string& compression) {
   PyObject* object = handle.ptr();
-  return BuildPyCallHandler(object);
+  SerializationOptions options;
+  COURIER_ASSIGN_OR_RETURN(options.float_encoding,
+                           ParseArrayEncoding(float_encoding));
+  COURIER_ASSIGN_OR_RETURN(options.compression.codec,
+                           ParseCompressionCodec(compression));
+  return std::shared_ptr<HandlerInterface>(
+      BuildPyCallHandler(object, options));
+}
+
+absl::StatusOr<std::shared_ptr<HandlerInterface>>
+BuildPyBatchedCallHandlerWrapper(py::handle& handle, int max_batch_size,
+                                 absl::Duration max_latency,
+                                 const std::string& float_encoding,
+                                 const std::string& compression) {
+  PyObject* object = handle.ptr();
+  SerializationOptions options;
+  COURIER_ASSIGN_OR_RETURN(options.float_encoding,
+                           ParseArrayEncoding(float_encoding));
+  COURIER_ASSIGN_OR_RETURN(options.compression.codec,
+                           ParseCompressionCodec(compression));
+  return std::shared_ptr<HandlerInterface>(BuildPyBatchedCallHandler(
+      object, max_batch_size, max_latency, options));
 }
 
 
@@ -50,6 +76,11 @@ PYBIND11_MODULE(pybind, m) {
   py::google::ImportStatusModule();
 
   m.def("BuildPyCallHandler", &BuildPyCallHandlerWrapper);
+  m.def("BuildPyBatchedCallHandler", &BuildPyBatchedCallHandlerWrapper);
+  m.def("CoalesceCalls", [](std::shared_ptr<HandlerInterface> handler) {
+    return std::shared_ptr<HandlerInterface>(
+        std::make_shared<CoalescingHandler>(std::move(handler)));
+  });
 
   py::class_<HandlerInterface, std::shared_ptr<HandlerInterface>>(
       m, "HandlerInterface");
@@ -0,0 +1,81 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/hedging.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace courier {
+namespace {
+
+// Number of recent latencies the percentile is computed over.
+constexpr int kMaxLatencies = 1024;
+
+// The percentile is recomputed every this many calls.
+constexpr int kDelayUpdateInterval = 64;
+
+}  // namespace
+
+HedgingController::HedgingController(const HedgingPolicy& policy)
+    : policy_(policy),
+      methods_(policy.methods.begin(), policy.methods.end()),
+      tokens_(policy.budget_burst),
+      delay_(policy.delay) {}
+
+absl::Duration HedgingController::StartCall() {
+  absl::MutexLock lock(&mu_);
+  ++stats_.calls;
+  tokens_ = std::min(policy_.budget_burst, tokens_ + policy_.max_hedged_ratio);
+  return delay_;
+}
+
+bool HedgingController::TryHedge() {
+  absl::MutexLock lock(&mu_);
+  if (tokens_ < 1) return false;
+  tokens_ -= 1;
+  ++stats_.hedged;
+  return true;
+}
+
+void HedgingController::FinishCall(absl::Duration latency, bool hedge_won) {
+  absl::MutexLock lock(&mu_);
+  if (hedge_won) ++stats_.hedge_wins;
+  if (policy_.latency_percentile <= 0 || policy_.latency_percentile >= 100) {
+    return;
+  }
+  if (latencies_.size() < kMaxLatencies) {
+    latencies_.push_back(latency);
+  } else {
+    latencies_[num_latencies_ % kMaxLatencies] = latency;
+  }
+  if (++num_latencies_ % kDelayUpdateInterval != 0) return;
+
+  std::vector<absl::Duration> latencies = latencies_;
+  auto nth = latencies.begin() +
+             static_cast<int>(policy_.latency_percentile / 100 *
+                              (latencies.size() - 1));
+  std::nth_element(latencies.begin(), nth, latencies.end());
+  delay_ = *nth;
+}
+
+HedgingStats HedgingController::stats() const {
+  absl::MutexLock lock(&mu_);
+  return stats_;
+}
+
+}  // namespace courier
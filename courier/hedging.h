@@ -0,0 +1,99 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_HEDGING_H_
+#define COURIER_HEDGING_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace courier {
+
+// Which calls of a client are hedged: if a call has not completed after a
+// delay, a duplicate is sent and whichever completes first wins, the other
+// one being cancelled. Only meant for idempotent methods.
+struct HedgingPolicy {
+  // Names of the methods whose calls are hedged.
+  std::vector<std::string> methods;
+
+  // Time after which a duplicate of a call is sent.
+  absl::Duration delay = absl::Milliseconds(10);
+
+  // If in (0, 100), the delay is instead the latency of this percentile of
+  // the recent hedged calls. `delay` is used until enough calls were seen.
+  double latency_percentile = 0;
+
+  // Maximum fraction of the calls which are hedged, and the number of
+  // duplicates which can be sent in a burst.
+  double max_hedged_ratio = 0.05;
+  double budget_burst = 10;
+};
+
+struct HedgingStats {
+  // Number of calls to the hedged methods.
+  int64_t calls = 0;
+  // Number of duplicates sent.
+  int64_t hedged = 0;
+  // Number of calls completed by their duplicate.
+  int64_t hedge_wins = 0;
+};
+
+// Keeps track of the latencies and of the hedging budget of a client.
+// Thread-safe.
+class HedgingController {
+ public:
+  explicit HedgingController(const HedgingPolicy& policy);
+
+  // Whether calls of `method_name` are hedged.
+  bool IsHedged(absl::string_view method_name) const {
+    return methods_.contains(method_name);
+  }
+
+  // Records the start of a call and returns the time after which to send its
+  // duplicate.
+  absl::Duration StartCall() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Takes a duplicate from the budget, returns false if there is none left.
+  bool TryHedge() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Records the completion of a call after `latency`, `hedge_won` telling
+  // whether the duplicate completed first.
+  void FinishCall(absl::Duration latency, bool hedge_won)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  HedgingStats stats() const ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  const HedgingPolicy policy_;
+  const absl::flat_hash_set<std::string> methods_;
+
+  mutable absl::Mutex mu_;
+  double tokens_ ABSL_GUARDED_BY(mu_);
+  // Latencies of the recent calls, used as a ring buffer.
+  std::vector<absl::Duration> latencies_ ABSL_GUARDED_BY(mu_);
+  int64_t num_latencies_ ABSL_GUARDED_BY(mu_) = 0;
+  absl::Duration delay_ ABSL_GUARDED_BY(mu_);
+  HedgingStats stats_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace courier
+
+#endif  // COURIER_HEDGING_H_
@@ -15,22 +15,44 @@
 #include "courier/platform/default/courier_service_impl.h"
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
+#include "absl/flags/flag.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "courier/blob_cache.h"
+#include "courier/chunking.h"
 #include "courier/courier_service.pb.h"
 #include "courier/platform/logging.h"
 #include "courier/platform/status_macros.h"
+#include "courier/publisher.h"
+#include "courier/response_cache.h"
 #include "courier/router.h"
 #include "courier/serialization/serialization.pb.h"
 
+ABSL_FLAG(int64_t, courier_server_blob_cache_bytes, int64_t{1} << 30,
+          "Capacity of the cache of call argument payloads which clients "
+          "send by digest, see courier::BlobCacheOptions.");
+
 namespace courier {
 
+// Maximum time a subscription stream waits for a new version before checking
+// whether it has been cancelled.
+constexpr absl::Duration kSubscriptionPollInterval = absl::Milliseconds(100);
+
+// Maximum number of threads, including the one serving the RPC, executing the
+// calls of a batch concurrently.
+constexpr int kMaxBatchCallThreads = 8;
+
 inline grpc::Status ToGrpcStatus(const absl::Status& s) {
   if (s.ok()) return grpc::Status::OK;
 
@@ -38,15 +60,47 @@ inline grpc::Status ToGrpcStatus(const absl::Status& s) {
                       std::string(s.message()));
 }
 
-CourierServiceImpl::CourierServiceImpl(Router* router) : router_(router) {
+CourierServiceImpl::CourierServiceImpl(Router* router)
+    : router_(router),
+      blob_cache_(absl::GetFlag(FLAGS_courier_server_blob_cache_bytes)) {
   COURIER_CHECK(router_ != nullptr);
 }
 
 grpc::Status CourierServiceImpl::Call(::grpc::ServerContext* context,
                                       const CallRequest* request,
                                       CallResponse* reply) {
-  absl::StatusOr<courier::CallResult> result =
-      router_->Call(request->method(), request->arguments());
+  // Payloads referenced by digest identify their content, so the arguments
+  // can be looked up before resolving them.
+  ResponseCache::Ticket ticket;
+  bool cacheable;
+  std::shared_ptr<const CallResult> cached =
+      router_->response_cache()->Lookup(
+          request->method(), request->arguments(), &ticket, &cacheable);
+  if (cached != nullptr) {
+    *reply->mutable_result() = *cached;
+    return grpc::Status();
+  }
+  absl::StatusOr<courier::CallResult> result;
+  if (request->has_blob_digests()) {
+    // Only the payloads referenced by digest are large, the copy is cheap.
+    CallArguments arguments = request->arguments();
+    std::vector<std::string> missing;
+    absl::Status status =
+        ResolveBlobDigests(&blob_cache_, *request, &arguments, &missing);
+    if (!status.ok()) return ToGrpcStatus(status);
+    if (!missing.empty()) {
+      for (std::string& digest : missing) {
+        reply->add_missing_blobs(std::move(digest));
+      }
+      return grpc::Status();
+    }
+    result = router_->Call(request->method(), arguments);
+  } else {
+    result = router_->Call(request->method(), request->arguments());
+  }
+  if (result.ok() && cacheable) {
+    router_->response_cache()->Insert(ticket, *result);
+  }
   if (result.ok()) {
     *reply->mutable_result() = std::move(result).value();
     return grpc::Status();
@@ -55,6 +109,126 @@ grpc::Status CourierServiceImpl::Call(::grpc::ServerContext* context,
   }
 }
 
+grpc::Status CourierServiceImpl::ChunkedCall(
+    ::grpc::ServerContext* context,
+    ::grpc::ServerReaderWriter<CallChunk, CallChunk>* stream) {
+  ChunkingOptions options;
+  ChunkAssembler assembler(options.max_call_size);
+  CallChunk chunk;
+  while (!assembler.complete() && stream->Read(&chunk)) {
+    absl::Status status = assembler.Add(std::move(chunk));
+    if (!status.ok()) return ToGrpcStatus(status);
+  }
+  if (!assembler.complete()) {
+    return grpc::Status(grpc::StatusCode::CANCELLED,
+                        "Stream ended before the request was complete.");
+  }
+  absl::StatusOr<CallChunk> request = assembler.Finish();
+  if (!request.ok()) return ToGrpcStatus(request.status());
+  if (!request->has_request()) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "Chunked call does not hold a request.");
+  }
+
+  absl::StatusOr<courier::CallResult> result = router_->Call(
+      request->request().method(), request->request().arguments());
+  if (!result.ok()) return ToGrpcStatus(result.status());
+
+  // Release the arguments before sending the (possibly equally large) result.
+  request = CallChunk();
+  CallChunk header;
+  *header.mutable_response()->mutable_result() = std::move(result).value();
+  std::vector<std::string> blobs;
+  ExtractBlobs(options.min_blob_size,
+               header.mutable_response()->mutable_result()->mutable_result(),
+               &blobs);
+  if (!WriteChunks(header, blobs, options.chunk_size,
+                   [stream](const CallChunk& chunk) {
+                     return stream->Write(chunk);
+                   })) {
+    return grpc::Status(grpc::StatusCode::CANCELLED,
+                        "Stream closed while sending the result.");
+  }
+  return grpc::Status();
+}
+
+namespace {
+
+void ExecuteBatchedCall(Router* router, ::grpc::ServerContext* context,
+                        const CallRequest& call, BatchCallResult* call_result) {
+  if (context->IsCancelled()) {
+    call_result->set_code(static_cast<int>(absl::StatusCode::kCancelled));
+    call_result->set_message("Batch call was cancelled.");
+    return;
+  }
+  absl::StatusOr<courier::CallResult> result =
+      router->Call(call.method(), call.arguments());
+  if (result.ok()) {
+    *call_result->mutable_result() = std::move(result).value();
+  } else {
+    call_result->set_code(static_cast<int>(result.status().code()));
+    call_result->set_message(std::string(result.status().message()));
+  }
+}
+
+}  // namespace
+
+grpc::Status CourierServiceImpl::BatchCall(::grpc::ServerContext* context,
+                                           const BatchCallRequest* request,
+                                           BatchCallResponse* reply) {
+  const int num_calls = request->calls_size();
+  reply->mutable_results()->Reserve(num_calls);
+  for (int i = 0; i < num_calls; ++i) reply->add_results();
+
+  // The calls are independent: they run concurrently, as they would if sent
+  // individually, each thread taking the next call not started yet.
+  std::atomic<int> next_call{0};
+  auto execute_calls = [&] {
+    for (int i = next_call++; i < num_calls; i = next_call++) {
+      ExecuteBatchedCall(router_, context, request->calls(i),
+                         reply->mutable_results(i));
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < std::min(num_calls, kMaxBatchCallThreads); ++i) {
+    threads.emplace_back(execute_calls);
+  }
+  execute_calls();
+  for (std::thread& thread : threads) thread.join();
+  return grpc::Status();
+}
+
+grpc::Status CourierServiceImpl::Subscribe(
+    ::grpc::ServerContext* context, const SubscribeRequest* request,
+    ::grpc::ServerWriter<SubscribeResponse>* writer) {
+  int64_t last_version = request->last_version();
+  while (!context->IsCancelled()) {
+    if (shutting_down_) {
+      return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                          "Server is shutting down.");
+    }
+    // Wakes up regularly to notice cancellation and shutdown.
+    absl::optional<Publisher::Version> latest =
+        router_->publisher()->WaitForUpdate(
+            request->topic(), last_version,
+            absl::Now() + kSubscriptionPollInterval);
+    if (!latest.has_value()) continue;
+
+    SubscribeResponse response;
+    response.set_version(latest->version);
+    // Send the shared value without copying it, it is released before the
+    // response goes out of scope.
+    response.unsafe_arena_set_allocated_value(
+        const_cast<SerializedObject*>(latest->value.get()));
+    const bool written = writer->Write(response);
+    response.unsafe_arena_release_value();
+    if (!written) break;
+    last_version = latest->version;
+  }
+  return grpc::Status(grpc::StatusCode::CANCELLED,
+                      "Subscription was cancelled.");
+}
+
 grpc::Status CourierServiceImpl::ListMethods(::grpc::ServerContext* context,
                                              const ListMethodsRequest* request,
                                              ListMethodsResponse* reply) {
@@ -15,12 +15,14 @@
 #ifndef COURIER_COURIER_SERVICE_IMPL_H_
 #define COURIER_COURIER_SERVICE_IMPL_H_
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
 #include "grpcpp/server_context.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
+#include "courier/blob_cache.h"
 #include "courier/courier_service.grpc.pb.h"
 #include "courier/courier_service.pb.h"
 #include "courier/router.h"
@@ -41,13 +43,42 @@ class CourierServiceImpl final : public CourierService::Service {
 
   // Calls the method handler registered under the name request->method()
   // and returns the result of the call over RPC. If no method is registered
-  // under the requested name, a NOT_FOUND error is returned.
+  // under the requested name, a NOT_FOUND error is returned. Calls of
+  // methods enabled in `Router::response_cache` are answered from the cache
+  // when possible, without calling the handler.
+  //
+  // Payloads of the arguments referenced by digest are resolved through the
+  // blob cache of the server first. If some of them are not held, the method
+  // is not called and the reply lists their digests instead.
   //
   // This function blocks until the execution has completed.
   // calls of the binding functions have completed.
   grpc::Status Call(::grpc::ServerContext* context, const CallRequest* request,
                     CallResponse* reply) override;
 
+  // Same as `Call` but receives the request and sends the result as a stream
+  // of bounded chunks, see `CallChunk`.
+  grpc::Status ChunkedCall(
+      ::grpc::ServerContext* context,
+      ::grpc::ServerReaderWriter<CallChunk, CallChunk>* stream) override;
+
+  // Executes the calls of the batch concurrently, on up to 8 threads, through
+  // the router and returns their individual results and statuses.
+  grpc::Status BatchCall(::grpc::ServerContext* context,
+                         const BatchCallRequest* request,
+                         BatchCallResponse* reply) override;
+
+  // Streams the versions of a value published through the router's
+  // `Publisher` until the client cancels the subscription or `Shutdown` is
+  // called.
+  grpc::Status Subscribe(
+      ::grpc::ServerContext* context, const SubscribeRequest* request,
+      ::grpc::ServerWriter<SubscribeResponse>* writer) override;
+
+  // Ends the subscription streams, which would otherwise keep the server from
+  // shutting down.
+  void Shutdown() { shutting_down_ = true; }
+
   // Returns a list of the names of all registered method handlers over RPC.
   // The returned list is advisory only. Presence on the list does not imply
   // that a call under that name will succeed, nor does absence from the list
@@ -62,6 +93,11 @@ class CourierServiceImpl final : public CourierService::Service {
  private:
   // Method handlers which are executed on incoming Call requests.
   Router* router_;
+
+  // Payloads of call arguments which clients send by digest.
+  BlobCache blob_cache_;
+
+  std::atomic<bool> shutting_down_{false};
 };
 
 }  // namespace courier
@@ -57,6 +57,7 @@ class ServerImpl : public Server {
 
   absl::Status Stop() {
     if (grpc_server_) {
+      service_.Shutdown();
       grpc_server_->Shutdown();
       LOG(INFO) << "Courier server on port " << port_ << " shutting down.";
     }
@@ -0,0 +1,56 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/publisher.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+int64_t Publisher::Publish(absl::string_view topic, SerializedObject value) {
+  auto shared_value =
+      std::make_shared<const SerializedObject>(std::move(value));
+  absl::MutexLock lock(&mu_);
+  Version& latest = topics_[topic];
+  ++latest.version;
+  // The previous value is released by its last subscriber still sending it.
+  latest.value = std::move(shared_value);
+  return latest.version;
+}
+
+absl::optional<Publisher::Version> Publisher::WaitForUpdate(
+    absl::string_view topic, int64_t last_version, absl::Time deadline) {
+  absl::MutexLock lock(&mu_);
+  // Versions are compared for equality rather than order so that subscribers
+  // also catch up with a restarted server, whose versions start over.
+  auto has_other = [this, topic, last_version]()
+                       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+                         auto it = topics_.find(topic);
+                         return it != topics_.end() &&
+                                it->second.version != last_version;
+                       };
+  if (!mu_.AwaitWithDeadline(absl::Condition(&has_other), deadline)) {
+    return absl::nullopt;
+  }
+  return topics_.find(topic)->second;
+}
+
+}  // namespace courier
@@ -0,0 +1,63 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_PUBLISHER_H_
+#define COURIER_PUBLISHER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+// Holds the latest version of the values a server publishes under named
+// topics, and lets subscribers wait for new versions. Only the latest version
+// of a topic is kept: a subscriber which falls behind skips the versions it
+// missed. Thread-safe.
+class Publisher {
+ public:
+  struct Version {
+    // Versions of a topic are numbered from one.
+    int64_t version = 0;
+    std::shared_ptr<const SerializedObject> value;
+  };
+
+  // Makes `value` the latest version of `topic` and wakes up its subscribers.
+  // Returns the number of the new version.
+  int64_t Publish(absl::string_view topic, SerializedObject value)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Blocks until the latest version of `topic` is not `last_version` and
+  // returns it, or returns nullopt once `deadline` has passed.
+  absl::optional<Version> WaitForUpdate(absl::string_view topic,
+                                        int64_t last_version,
+                                        absl::Time deadline)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::string, Version> topics_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace courier
+
+#endif  // COURIER_PUBLISHER_H_
@@ -23,15 +23,25 @@ client = courier.Client('my_server')
 result = client.my_function(4, 7)  # 11, evaluated on the server.
 """
 
+import asyncio
 from concurrent import futures
 import datetime
-from typing import List, Optional, Union
+import threading
+from typing import Any, Callable, Dict, List, Optional, Sequence, Tuple, Union
+import weakref
 
 from courier.python import py_client
 from pybind11_abseil.status import StatusNotOk as StatusThrown  # pytype: disable=import-error
+from pybind11_abseil.status import StatusCode  # pytype: disable=import-error
 from pybind11_abseil.status import StatusNotOk  # pytype: disable=import-error
 
 
+# A value serialized once, `Serialized(value)`, whose serialized form is copied
+# wherever it appears in call arguments or results. Saves re-serializing large
+# values sent many times, such as the latest weights returned by a server.
+Serialized = py_client.Serialized
+
+
 def translate_status(s):
   """Translate Pybind11 status to Exception."""
   exc = StatusNotOk(s.message())
@@ -41,6 +51,38 @@ def translate_status(s):
 
 
 
+def _future_setters(f: futures.Future):
+  """Returns setters of the result and of the error status of `f`.
+
+  The call of the future could have been already cancelled by the user, in
+  which case its outcome is dropped.
+  """
+
+  def set_result(value):
+    try:
+      f.set_result(value)
+    except futures.InvalidStateError:  # pytype: disable=module-attr
+      pass
+
+  def set_exception(s):
+    try:
+      f.set_exception(translate_status(s))
+    except futures.InvalidStateError:  # pytype: disable=module-attr
+      pass
+
+  return set_result, set_exception
+
+
+def _cancel_on_cancellation(f: futures.Future, canceller):
+  """Cancels the call of `f` through `canceller` once `f` is cancelled."""
+
+  def done_callback(f):
+    if f.cancelled():
+      canceller.Cancel()
+
+  f.add_done_callback(done_callback)
+
+
 def exception_handler(func):
 
   def inner_function(*args, **kwargs):
@@ -61,11 +103,17 @@ class _AsyncClient:
       wait_for_ready: bool,
       call_timeout: datetime.timedelta,
       compress: bool,
+      float_encoding: str,
+      compression: str,
+      bytes_as_memoryview: bool,
   ):
     self._client = client
     self._wait_for_ready = wait_for_ready
     self._call_timeout = call_timeout
     self._compress = compress
+    self._float_encoding = float_encoding
+    self._compression = compression
+    self._bytes_as_memoryview = bytes_as_memoryview
 
   def __getattr__(self, method):
     """Gets a callable function for the method that returns a future.
@@ -79,25 +127,122 @@ class _AsyncClient:
 
     def call(*args, **kwargs):  
       f = futures.Future()
-
-      def set_exception(s):
-        try:
-          f.set_exception(translate_status(s))
-        except futures.InvalidStateError:  # pytype: disable=module-attr
-          # Call could have been already canceled by the user.
-          pass
-
+      set_result, set_exception = _future_setters(f)
       canceller = self._client.AsyncPyCall(method, list(args), kwargs,
-                                           f.set_result, set_exception,
+                                           set_result, set_exception,
                                            self._wait_for_ready,
-                                           self._call_timeout, self._compress)
+                                           self._call_timeout, self._compress,
+                                           self._float_encoding,
+                                           self._compression,
+                                           self._bytes_as_memoryview)
+      _cancel_on_cancellation(f, canceller)
+      return f
+
+    return call
 
-      def done_callback(f):
-        if f.cancelled():
-          canceller.Cancel()
 
-      f.add_done_callback(done_callback)
-      return f
+class _LoopCompletions:
+  """Results of the calls made from an asyncio event loop.
+
+  Completed calls are collected in a `PyCompletionQueue` whose eventfd is
+  watched by the event loop. A single wakeup of the loop handles all the
+  calls which completed in the meantime.
+  """
+
+  def __init__(self, loop: asyncio.AbstractEventLoop):
+    self.queue = py_client.PyCompletionQueue()
+    self._futures = {}
+    self._next_tag = 0
+    loop.add_reader(self.queue.fileno(), self._on_readable)
+
+  def create_future(self) -> Tuple[int, asyncio.Future]:
+    """Returns a new future and the tag under which its result is queued."""
+    tag = self._next_tag
+    self._next_tag += 1
+    future = asyncio.get_running_loop().create_future()
+    self._futures[tag] = future
+    return tag, future
+
+  def discard(self, tag: int):
+    del self._futures[tag]
+
+  def _on_readable(self):
+    for tag, ok, value in self.queue.Drain():
+      future = self._futures.pop(tag)
+      if future.done():
+        # Call was cancelled.
+        continue
+      if ok:
+        future.set_result(value)
+      else:
+        future.set_exception(translate_status(value))
+
+
+# Completion queues of the running event loops.
+_loop_completions = weakref.WeakKeyDictionary()
+
+
+def _get_loop_completions() -> _LoopCompletions:
+  loop = asyncio.get_running_loop()
+  completions = _loop_completions.get(loop)
+  if completions is None:
+    completions = _LoopCompletions(loop)
+    _loop_completions[loop] = completions
+  return completions
+
+
+class _AsyncioClient:
+  """Asynchronous client for asyncio event loops."""
+
+  def __init__(
+      self,
+      client: 'Client',
+      wait_for_ready: bool,
+      call_timeout: datetime.timedelta,
+      compress: bool,
+      float_encoding: str,
+      compression: str,
+      bytes_as_memoryview: bool,
+  ):
+    self._client = client
+    self._wait_for_ready = wait_for_ready
+    self._call_timeout = call_timeout
+    self._compress = compress
+    self._float_encoding = float_encoding
+    self._compression = compression
+    self._bytes_as_memoryview = bytes_as_memoryview
+
+  def __getattr__(self, method):
+    """Gets a coroutine function for the method.
+
+    Args:
+      method: Name of the method.
+
+    Returns:
+      Coroutine function for the method. Cancelling the coroutine cancels the
+      call.
+    """
+
+    async def call(*args, **kwargs):
+      completions = _get_loop_completions()
+      tag, future = completions.create_future()
+      try:
+        canceller = self._client.QueuedPyCall(method, list(args), kwargs,
+                                              completions.queue, tag,
+                                              self._wait_for_ready,
+                                              self._call_timeout,
+                                              self._compress,
+                                              self._float_encoding,
+                                              self._compression,
+                                              self._bytes_as_memoryview)
+      except StatusThrown as e:
+        completions.discard(tag)
+        raise translate_status(e.status)
+      try:
+        return await future
+      except asyncio.CancelledError:
+        canceller.Cancel()
+        raise
 
     return call
 
@@ -111,32 +256,124 @@ class Client:
 
   def __init__(
       self,
-      server_address: str,
+      server_address: Union[str, Sequence[str]],
       compress: bool = False,
       call_timeout: Optional[Union[int, float, datetime.timedelta]] = None,
       wait_for_ready: bool = True,
+      float_encoding: Optional[str] = None,
+      compression: Optional[str] = None,
+      chunked: bool = False,
+      bytes_as_memoryview: bool = False,
+      num_polling_threads: int = 0,
+      num_channels: int = 1,
+      batch_size: int = 0,
+      batch_delay: Union[int, float, datetime.timedelta] = 0.0005,
+      hedged_methods: Sequence[str] = (),
+      hedging_delay: Union[int, float, datetime.timedelta] = 0.01,
+      hedging_percentile: Optional[float] = None,
+      blob_cache_min_size: int = 0,
   ):
     """Initiates a new client that will connect to a server.
 
     Args:
       server_address: Address of the server. If the string does not start
         with "/" or "localhost" then it will be interpreted as a custom BNS
-        registered server_name (constructor passed to Server).
-      compress: Whether to use compression.
+        registered server_name (constructor passed to Server). A list of
+        addresses makes a client of a replicated service: each call goes to
+        the replica with the fewest calls in flight and unavailable replicas
+        are skipped until they recover.
+      compress: Whether to use gRPC (gzip) compression of whole messages.
       call_timeout: If set, uses a timeout for all calls.
       wait_for_ready: Sets `wait_for_ready` on the gRPC::ClientContext.
         This specifies whether to wait for a server to come online.
+      float_encoding: If set, float32 and float64 numpy arrays in the call
+        arguments are down-cast for transport and up-cast back to their
+        original dtype on the server. One of 'float16', 'bfloat16' or 'int8'
+        (per-array affine quantization). The encodings are lossy.
+      compression: If set, numpy arrays in the call arguments are compressed
+        with this codec ('snappy'). Multi-byte elements are byte-shuffled
+        first, which helps with float data. Small and incompressible arrays
+        are sent as is. Much cheaper than `compress` for large arrays.
+      chunked: If set, synchronous calls transfer large arguments and results
+        in bounded chunks over a streaming RPC. Required for payloads larger
+        than 2GB. Calls made through `futures` are not affected.
+      bytes_as_memoryview: If set, bytes in call results are returned as
+        read-only memoryviews over the received message instead of copies.
+      num_polling_threads: If positive, the client gets its own threads
+        processing the completions of asynchronous calls. By default, all
+        clients of the process share a bounded pool of threads (see the
+        `courier_client_polling_threads` flag) as well as their connections.
+      num_channels: Number of connections to the server to spread the calls
+        over. Each call goes to the connection with the fewest calls in
+        flight. Helps saturating a server from a single high-throughput
+        client.
+      batch_size: If positive, calls made through `futures` and `aio` are
+        sent to the server in batches of up to this many calls, saving the
+        per-call RPC overhead. The server executes the calls of a batch
+        concurrently and each call still completes individually.
+        `call_timeout` and `wait_for_ready` then apply to whole batches and
+        cancelling a call no longer cancels the RPC.
+      batch_delay: Maximum time a call waits for a batch to fill up, in
+        seconds if a number.
+      hedged_methods: Names of idempotent methods whose calls made through
+        `futures` and `aio` are hedged: if a call has not completed after
+        `hedging_delay`, a duplicate is sent, preferably to another replica,
+        and the first response wins. At most 5% of the calls are duplicated.
+        Batched calls are not hedged.
+      hedging_delay: Time after which a call is duplicated, in seconds if a
+        number.
+      hedging_percentile: If set, the hedging delay follows this percentile
+        (e.g. 95) of the latencies of the recent hedged calls instead.
+      blob_cache_min_size: If positive, bytes and numpy arrays of at least this
+        many bytes in call arguments are sent by content hash once the server
+        holds them, which it asks for otherwise. Saves resending the same
+        large arguments. Batched and chunked calls are not affected.
     """
-    self._init_args = (server_address, compress)
-    self._address = str(server_address)
+    self._init_args = (server_address, compress, call_timeout, wait_for_ready,
+                       float_encoding, compression, chunked,
+                       bytes_as_memoryview, num_polling_threads, num_channels,
+                       batch_size, batch_delay, hedged_methods, hedging_delay,
+                       hedging_percentile, blob_cache_min_size)
+    if isinstance(server_address, (list, tuple)):
+      addresses = [str(address) for address in server_address]
+      self._address = ','.join(addresses)
+      self._client = py_client.PyClient(addresses, num_polling_threads,
+                                        num_channels)
+    else:
+      self._address = str(server_address)
+      self._client = py_client.PyClient(self._address, num_polling_threads,
+                                        num_channels)
     self._compress = compress
-    self._client = py_client.PyClient(self._address)
     self._call_timeout = call_timeout if call_timeout else datetime.timedelta(0)
     if not isinstance(self._call_timeout, datetime.timedelta):
       self._call_timeout = datetime.timedelta(seconds=self._call_timeout)
     self._wait_for_ready = wait_for_ready
+    if hedged_methods:
+      if not isinstance(hedging_delay, datetime.timedelta):
+        hedging_delay = datetime.timedelta(seconds=hedging_delay)
+      self._client.EnableHedging(
+          list(hedged_methods), hedging_delay, hedging_percentile or 0.0)
+    if blob_cache_min_size > 0:
+      self._client.EnableBlobCache(blob_cache_min_size)
+    if batch_size > 0:
+      if not isinstance(batch_delay, datetime.timedelta):
+        batch_delay = datetime.timedelta(seconds=batch_delay)
+      self._client.EnableBatching(batch_size, batch_delay,
+                                  self._wait_for_ready, self._call_timeout,
+                                  self._compress)
+    self._float_encoding = float_encoding or ''
+    self._compression = compression or ''
+    self._chunked = chunked
+    self._bytes_as_memoryview = bytes_as_memoryview
     self._async_client = _AsyncClient(self._client, self._wait_for_ready,
-                                      self._call_timeout, self._compress)
+                                      self._call_timeout, self._compress,
+                                      self._float_encoding, self._compression,
+                                      self._bytes_as_memoryview)
+    self._asyncio_client = _AsyncioClient(self._client, self._wait_for_ready,
+                                          self._call_timeout, self._compress,
+                                          self._float_encoding,
+                                          self._compression,
+                                          self._bytes_as_memoryview)
 
   def __reduce__(self):
     return self.__class__, self._init_args
@@ -150,6 +387,14 @@ class Client:
     """Gets an asynchronous client on which a method call returns a future."""
     return self._async_client
 
+  @property
+  def aio(self) -> _AsyncioClient:
+    """Gets an asynchronous client on which a method call is a coroutine.
+
+    Must be used from within a running asyncio event loop.
+    """
+    return self._asyncio_client
+
   def __getattr__(self, method: str):
     """Gets a callable function for the method and sets it as an attribute.
 
@@ -163,7 +408,9 @@ class Client:
     def func(*args, **kwargs):
       return self._client.PyCall(method, list(args), kwargs,
                                  self._wait_for_ready, self._call_timeout,
-                                 self._compress)
+                                 self._compress, self._float_encoding,
+                                 self._compression, self._chunked,
+                                 self._bytes_as_memoryview)
 
     setattr(self, method, func)
     return func
@@ -180,3 +427,171 @@ def list_methods(client: Client) -> List[str]:
     List of method names.
   """
   return client._client.ListMethods()  
+
+
+@exception_handler
+def broadcast(
+    clients: Sequence[Client],
+    method: str,
+    args: Sequence[Any] = (),
+    kwargs: Optional[Dict[str, Any]] = None,
+    timeout: Optional[Union[int, float, datetime.timedelta]] = None,
+) -> List[futures.Future]:
+  """Calls a method with the same arguments on several clients.
+
+  The arguments are serialized once and the resulting request is shared by
+  all calls, which run concurrently. The settings of the first client
+  (timeout, encodings, compression, ...) apply to all calls. Cancelling a
+  future cancels its call.
+
+  Args:
+    clients: Clients to call the method on.
+    method: Name of the method.
+    args: Positional arguments of the method.
+    kwargs: Keyword arguments of the method.
+    timeout: If set, replaces the call timeout of the first client, in
+      seconds if a number.
+
+  Returns:
+    One future per client, in the order of `clients`.
+  """
+  if not clients:
+    return []
+  first = clients[0]
+  if timeout is None:
+    timeout = first._call_timeout
+  elif not isinstance(timeout, datetime.timedelta):
+    timeout = datetime.timedelta(seconds=timeout)
+  fs = [futures.Future() for _ in clients]
+  setters = [_future_setters(f) for f in fs]
+  cancellers = py_client.Broadcast(
+      [c._client for c in clients], method, list(args), kwargs or {},
+      [set_result for set_result, _ in setters],
+      [set_exception for _, set_exception in setters], first._wait_for_ready,
+      timeout, first._compress, first._float_encoding, first._compression,
+      first._bytes_as_memoryview)
+  for f, canceller in zip(fs, cancellers):
+    _cancel_on_cancellation(f, canceller)
+  return fs
+
+
+def gather(
+    clients: Sequence[Client],
+    method: str,
+    args: Sequence[Any] = (),
+    kwargs: Optional[Dict[str, Any]] = None,
+    timeout: Optional[Union[int, float, datetime.timedelta]] = None,
+) -> List[Any]:
+  """Same as `broadcast` but waits for the calls to complete.
+
+  Args:
+    clients: Clients to call the method on.
+    method: Name of the method.
+    args: Positional arguments of the method.
+    kwargs: Keyword arguments of the method.
+    timeout: If set, the deadline of the calls, in seconds if a number.
+      Replaces the call timeout of the first client.
+
+  Returns:
+    One entry per client, in the order of `clients`: the result of its call,
+    or the exception it raised. Calls which did not complete in time are
+    cancelled and reported as `TimeoutError`.
+  """
+  if timeout is not None and not isinstance(timeout, datetime.timedelta):
+    timeout = datetime.timedelta(seconds=timeout)
+  fs = broadcast(clients, method, args, kwargs, timeout)
+  futures.wait(fs, timeout=timeout.total_seconds() if timeout else None)
+  results = []
+  for f in fs:
+    # The calls end at their deadline, the futures may be a little late.
+    if not f.done():
+      f.cancel()
+    if f.cancelled() or (timeout is not None and
+                         getattr(f.exception(), 'code', None)
+                         == StatusCode.DEADLINE_EXCEEDED):
+      results.append(TimeoutError(f'Call to {method} timed out.'))
+    elif f.exception() is not None:
+      results.append(f.exception())
+    else:
+      results.append(f.result())
+  return results
+
+
+def retry_stats(client: Client) -> Dict[str, int]:
+  """Gets the retry counters of the client.
+
+  Args:
+    client: A client instance.
+
+  Returns:
+    Dictionary with the number of `retries` made by the calls of the client,
+    and the number of them which were delayed because they exceeded the retry
+    budget (`budget_exhausted`).
+  """
+  return client._client.RetryStats()
+
+
+class Subscription:
+  """Iterator over the versions of a value published by a server.
+
+  Yields `(version, value)` tuples. Each step returns the latest version at
+  that time: a subscriber which iterates slower than the value is published
+  skips the intermediate versions. If the server restarts, the subscription
+  resumes with the versions it publishes after the restart. Iteration stops
+  once `cancel` has been called.
+  """
+
+  def __init__(self, client: Client, topic: str, last_version: int = 0):
+    self._subscription = client._client.Subscribe(
+        topic, last_version, client._wait_for_ready)
+    self._last_version = last_version
+
+  @property
+  def last_version(self) -> int:
+    """Gets the version returned last, or the initial `last_version`."""
+    return self._last_version
+
+  def __iter__(self):
+    return self
+
+  def __next__(self) -> Tuple[int, Any]:
+    try:
+      version, value = self._subscription.Next()
+    except StatusThrown as e:
+      if e.status.code() == StatusCode.CANCELLED:
+        raise StopIteration from None
+      raise translate_status(e.status) from None
+    self._last_version = version
+    return version, value
+
+  def cancel(self):
+    """Ends the subscription, also when blocked in another thread."""
+    self._subscription.Cancel()
+
+
+def subscribe(client: Client,
+              topic: str,
+              callback: Optional[Callable[[int, Any], None]] = None,
+              last_version: int = 0) -> Subscription:
+  """Subscribes to a value which the server publishes with `Server.Publish`.
+
+  Args:
+    client: A client instance.
+    topic: Name of the value.
+    callback: If set, called with the number and the value of every version
+      received, from a daemon thread, until the subscription is cancelled.
+    last_version: Version already known to the subscriber, which is skipped.
+
+  Returns:
+    The subscription. Iterate over it to receive the versions unless
+    `callback` is set.
+  """
+  subscription = Subscription(client, topic, last_version)
+  if callback is not None:
+
+    def run():
+      for version, value in subscription:
+        callback(version, value)
+
+    threading.Thread(target=run, daemon=True).start()
+  return subscription
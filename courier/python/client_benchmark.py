@@ -0,0 +1,72 @@
+# Copyright 2020 DeepMind Technologies Limited. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Measures the async call throughput of a single client.
+
+Issues `--num_calls` concurrent `futures` calls against a local server for
+each number of polling threads in `--polling_threads` and prints the
+achieved calls per second.
+"""
+
+import time
+
+from absl import app
+from absl import flags
+
+from courier.python import client  # pytype: disable=import-error
+from courier.python import py_server  # pytype: disable=import-error
+
+FLAGS = flags.FLAGS
+flags.DEFINE_integer('num_calls', 50000, 'Number of calls per measurement.')
+flags.DEFINE_integer('max_in_flight', 2000,
+                     'Maximum number of calls pending at once.')
+flags.DEFINE_list('polling_threads', ['0', '1', '2', '4', '8'],
+                  'Numbers of client polling threads to measure, 0 measures '
+                  'the shared client runtime.')
+
+
+def _measure(address: str, num_polling_threads: int) -> float:
+  """Returns the number of async calls per second."""
+  my_client = client.Client(address, num_polling_threads=num_polling_threads)
+  my_client.echo(0)  # Connect before measuring.
+  start = time.time()
+  pending = []
+  for i in range(FLAGS.num_calls):
+    pending.append(my_client.futures.echo(i))
+    if len(pending) >= FLAGS.max_in_flight:
+      for f in pending:
+        f.result()
+      pending = []
+  for f in pending:
+    f.result()
+  return FLAGS.num_calls / (time.time() - start)
+
+
+def main(argv):
+  if len(argv) > 1:
+    raise app.UsageError('Too many command-line arguments.')
+  server = py_server.Server(thread_pool_size=64)
+  server.Bind('echo', lambda x: x)
+  server.Start()
+  try:
+    for num_polling_threads in FLAGS.polling_threads:
+      calls_per_second = _measure(server.address, int(num_polling_threads))
+      print(f'polling_threads={num_polling_threads}: '
+            f'{calls_per_second:.0f} calls/s')
+  finally:
+    server.Stop()
+
+
+if __name__ == '__main__':
+  app.run(main)
@@ -14,17 +14,28 @@
 
 """Tests for courier.python.py_client."""
 
+import array
+import asyncio
 from concurrent import futures
 import datetime
+import mmap
+import os
 import pickle
+import subprocess
+import sys
+import textwrap
 import threading
 import time
 from absl.testing import absltest
 
 from courier.python import client  # pytype: disable=import-error
 from courier.python import py_server  # pytype: disable=import-error
+from courier.python import sharded_client  # pytype: disable=import-error
+from courier.python import versioning  # pytype: disable=import-error
+from courier.serialization import pybind as serialization  # pytype: disable=import-error
 
 import mock
+import numpy as np
 
 from pybind11_abseil.status import StatusNotOk  # pytype: disable=import-error
 
@@ -53,6 +64,7 @@ class PyIntegrationTest(absltest.TestCase):
     self._server.Bind('rebind', lambda: 1234)
     self._server.Bind('bytes_value', lambda: b'1234')
     self._server.Bind('unicode_value', lambda: u'1234')
+    self._server.Bind('identity', lambda x: x)
     self._server.Start()
 
     self._client = client.Client(self._server.address)
@@ -68,6 +80,7 @@ class PyIntegrationTest(absltest.TestCase):
     self._server.Unbind('rebind')
     self._server.Unbind('bytes_value')
     self._server.Unbind('unicode_value')
+    self._server.Unbind('identity')
 
   def testLambdaCall(self):
     result = self._client.lambda_add(12, 5)
@@ -125,12 +138,91 @@ class PyIntegrationTest(absltest.TestCase):
     with self.assertRaisesRegex(StatusNotOk, expected_msg):
       future.result()
 
+  def testBatchedCalls(self):
+    my_client = client.Client(self._server.address, batch_size=4)
+    calls = [my_client.futures.lambda_add(i, 1) for i in range(10)]
+    failing = my_client.futures.exception_method()
+    self.assertEqual([f.result() for f in calls], list(range(1, 11)))
+    with self.assertRaisesRegex(StatusNotOk, r'Exception method called'):
+      failing.result()
+
+  def testBatchedCallsRunConcurrently(self):
+    barrier = threading.Barrier(4)
+    self._server.Bind('wait_for_all', lambda: barrier.wait(10))
+    my_client = client.Client(
+        self._server.address, batch_size=4, batch_delay=1)
+    calls = [my_client.futures.wait_for_all() for _ in range(4)]
+    # The calls of the batch only return once all of them are executing.
+    self.assertCountEqual([f.result() for f in calls], range(4))
+
+  def testHedgedCalls(self):
+    num_calls = []
+    release = threading.Event()
+
+    def slow_first_call(x):
+      num_calls.append(x)
+      if len(num_calls) == 1:
+        release.wait(10)
+      return x
+
+    self._server.Bind('slow_first_call', slow_first_call)
+    my_client = client.Client(
+        self._server.address,
+        hedged_methods=['slow_first_call'],
+        hedging_delay=0.05)
+    start = time.time()
+    self.assertEqual(my_client.futures.slow_first_call(3).result(), 3)
+    self.assertLess(time.time() - start, 5)
+    self.assertLen(num_calls, 2)
+    release.set()
+
+  def testServerSideBatching(self):
+    batch_sizes = []
+
+    def double(x):
+      batch_sizes.append(len(x))
+      return {'y': x * 2}
+
+    # Waits long enough for the concurrent calls to fill up the batches.
+    self._server.BindBatched('double', double, max_batch_size=4,
+                             max_latency=0.5)
+    calls = [self._client.futures.double(np.full(3, i)) for i in range(10)]
+    for i, f in enumerate(calls):
+      np.testing.assert_array_equal(f.result()['y'], np.full(3, 2 * i))
+    self.assertEqual(sum(batch_sizes), 10)
+    self.assertGreater(max(batch_sizes), 1)
+
+  def testAsyncioCall(self):
+
+    async def calls():
+      return await asyncio.gather(
+          *[self._client.aio.lambda_add(i, 1) for i in range(10)])
+
+    self.assertEqual(asyncio.run(calls()), list(range(1, 11)))
+
+  def testAsyncioCancel(self):
+
+    async def call():
+      task = asyncio.ensure_future(self._client.aio.slow_method())
+      await asyncio.sleep(0.1)
+      task.cancel()
+      with self.assertRaises(asyncio.CancelledError):
+        await task
+      # Results of later calls are still delivered.
+      return await self._client.aio.no_args()
+
+    self.assertEqual(asyncio.run(call()), 1000)
+
+  def testAsyncioException(self):
+    with self.assertRaisesRegex(StatusNotOk, r'Exception method called'):
+      asyncio.run(self._client.aio.exception_method())
+
   def testListMethods(self):
     self.assertCountEqual(
         client.list_methods(self._client), [
             'no_args', 'lambda_add', 'add_default', 'exception_method',
             'slow_method', 'method_add', 'rebind', 'bytes_value',
-            'unicode_value',
+            'unicode_value', 'identity',
         ])
 
 
@@ -146,6 +238,241 @@ class PyIntegrationTest(absltest.TestCase):
     result = self._client.unicode_value()
     self.assertEqual(result, u'1234')
 
+  def testFloatEncoding(self):
+    value = np.linspace(-1., 1., 11).astype(np.float32).reshape(1, 11)
+    for encoding in ('float16', 'bfloat16', 'int8'):
+      my_client = client.Client(self._server.address, float_encoding=encoding)
+      result = my_client.identity(value)
+      self.assertEqual(result.dtype, np.float32)
+      self.assertEqual(result.shape, value.shape)
+      np.testing.assert_allclose(result, value, atol=1e-2)
+
+  def testArrayCompression(self):
+    value = np.tile(np.linspace(-1., 1., 1024, dtype=np.float32), 64)
+    my_client = client.Client(self._server.address, compression='snappy')
+    for array in (value, value.astype(np.int64), value[:16]):
+      result = my_client.identity(array)
+      self.assertEqual(result.dtype, array.dtype)
+      np.testing.assert_array_equal(result, array)
+
+  def testChunkedCall(self):
+    my_client = client.Client(self._server.address, chunked=True)
+    value = {'a': b'x' * (3 << 20), 'b': [np.arange(1 << 20), 1]}
+    result = my_client.identity(value)
+    self.assertEqual(result['a'], value['a'])
+    np.testing.assert_array_equal(result['b'][0], value['b'][0])
+    self.assertEqual(result['b'][1], 1)
+
+  def testBytesLikeValues(self):
+    result = self._client.identity(bytearray(b'1234'))
+    self.assertIsInstance(result, bytearray)
+    self.assertEqual(result, b'1234')
+    result = self._client.identity(memoryview(b'1234'))
+    self.assertIsInstance(result, memoryview)
+    self.assertEqual(result, b'1234')
+
+  def testBytesAsMemoryview(self):
+    my_client = client.Client(self._server.address, bytes_as_memoryview=True)
+    result = my_client.identity(b'1234')
+    self.assertIsInstance(result, memoryview)
+    self.assertTrue(result.readonly)
+    self.assertEqual(result.tobytes(), b'1234')
+    result = my_client.futures.identity(b'1234').result()
+    self.assertEqual(result.tobytes(), b'1234')
+    # Reduced objects are rebuilt from bytes, not memoryviews.
+    result = my_client.identity(array.array('i', [1, 2, 3]))
+    self.assertEqual(result, array.array('i', [1, 2, 3]))
+
+  def testMultipleChannels(self):
+    my_client = client.Client(self._server.address, num_channels=3)
+    futures = [my_client.futures.lambda_add(i, 1) for i in range(20)]
+    self.assertEqual([f.result() for f in futures], list(range(1, 21)))
+    self.assertEqual(my_client.lambda_add(1, 2), 3)
+
+  def testReplicatedClientSkipsUnavailableReplicas(self):
+    my_client = client.Client(['[::]:12345', self._server.address])
+    for i in range(10):
+      self.assertEqual(my_client.lambda_add(i, 1), i + 1)
+    futures = [my_client.futures.lambda_add(i, 1) for i in range(20)]
+    self.assertEqual([f.result() for f in futures], list(range(1, 21)))
+
+  def testShardedClient(self):
+    servers = [py_server.Server() for _ in range(3)]
+    for shard, server in enumerate(servers):
+      server.Bind('shard_of', lambda key, shard=shard: shard)
+      server.Bind('lookup',
+                  lambda keys, shard=shard: [(shard, key) for key in keys])
+      server.Start()
+    my_client = sharded_client.ShardedClient(
+        [server.address for server in servers])
+    keys = [f'key_{i}' for i in range(20)]
+    shards = [my_client.shard_of(key) for key in keys]
+    self.assertEqual(shards, [my_client.shard(key) for key in keys])
+    self.assertGreater(len(set(shards)), 1)
+    self.assertEqual(my_client.futures.shard_of(keys[0]).result(), shards[0])
+    self.assertEqual(
+        my_client.call_multi('lookup', keys), list(zip(shards, keys)))
+    for server in servers:
+      server.Stop()
+
+  def testShardKeys(self):
+    ring = sharded_client.ConsistentHashRing(['a', 'b', 'c'])
+    for i in range(20):
+      self.assertEqual(ring.shard(np.int64(i)), ring.shard(i))
+      self.assertEqual(ring.shard((np.int32(i), np.str_('x'))),
+                       ring.shard((i, 'x')))
+    with self.assertRaisesRegex(TypeError, 'Unsupported key type float'):
+      ring.shard(1.5)
+
+  def testBroadcastAndGather(self):
+    clients = [client.Client(self._server.address) for _ in range(3)]
+    fs = client.broadcast(clients, 'lambda_add', (1, 2))
+    self.assertEqual([f.result() for f in fs], [3, 3, 3])
+    results = client.gather(clients, 'identity', kwargs={'x': np.arange(4)})
+    for result in results:
+      np.testing.assert_array_equal(result, np.arange(4))
+    results = client.gather(clients, 'exception_method')
+    for result in results:
+      self.assertIsInstance(result, StatusNotOk)
+
+  def testGatherTimeout(self):
+    clients = [client.Client(self._server.address) for _ in range(2)]
+    start = time.time()
+    results = client.gather(clients, 'slow_method', timeout=0.5)
+    self.assertLess(time.time() - start, 4)
+    for result in results:
+      self.assertIsInstance(result, TimeoutError)
+
+  def testBroadcastCancel(self):
+    fs = client.broadcast([self._client], 'slow_method')
+    self.assertTrue(fs[0].cancel())
+    with self.assertRaises(futures.CancelledError):
+      fs[0].result()
+
+  def testSubscribe(self):
+    self._server.Publish('weights', np.zeros(3))
+    subscription = client.subscribe(self._client, 'weights')
+    version, value = next(subscription)
+    self.assertEqual(version, 1)
+    np.testing.assert_array_equal(value, np.zeros(3))
+    self._server.Publish('weights', np.ones(3))
+    self._server.Publish('weights', np.full(3, 2.))
+    version, value = next(subscription)
+    self.assertEqual(version, 3)
+    np.testing.assert_array_equal(value, np.full(3, 2.))
+    self.assertEqual(subscription.last_version, 3)
+    subscription.cancel()
+    with self.assertRaises(StopIteration):
+      next(subscription)
+
+  def testVersionedPull(self):
+    params = {'frozen': np.zeros(1000), 'trained': np.zeros(10)}
+    my_server = py_server.Server()
+    my_server.Bind('get_params', lambda: params, versioned=True)
+    my_server.Start()
+    my_client = client.Client(my_server.address)
+    pull = versioning.VersionedPull(my_client, 'get_params')
+    result = pull()
+    self.assertEqual(pull.version, 1)
+    np.testing.assert_array_equal(result['frozen'], np.zeros(1000))
+    params['trained'] = np.ones(10)
+    delta = my_client.get_params(
+        **{versioning.KNOWN_VERSION_KWARG: (pull._epoch, pull.version)})
+    self.assertEqual(list(delta['leaves']), [1])
+    result = pull()
+    self.assertEqual(pull.version, 2)
+    np.testing.assert_array_equal(result['frozen'], np.zeros(1000))
+    np.testing.assert_array_equal(result['trained'], np.ones(10))
+    # Regular calls still return the full result.
+    np.testing.assert_array_equal(my_client.get_params()['trained'],
+                                  np.ones(10))
+    my_server.Stop()
+
+  def testBlobCache(self):
+    my_client = client.Client(self._server.address, blob_cache_min_size=1024)
+    data = np.arange(1000)
+    for _ in range(3):
+      np.testing.assert_array_equal(my_client.identity(data), data)
+      self.assertEqual(my_client.futures.identity(b'x' * 2000).result(),
+                       b'x' * 2000)
+
+  def testBlobCacheResendsMissingBlobs(self):
+    servers = [py_server.Server() for _ in range(2)]
+    for i, server in enumerate(servers):
+      server.Bind('size', lambda x, i=i: (i, len(x)))
+      server.Start()
+    # Calls alternate between the replicas. Once one of them holds the blob,
+    # the client sends it by digest and the other replica asks for it.
+    my_client = client.Client([server.address for server in servers],
+                              blob_cache_min_size=1024)
+    data = os.urandom(4096)
+    replicas = set()
+    for _ in range(3):
+      replica, size = my_client.size(data)
+      self.assertEqual(size, len(data))
+      replicas.add(replica)
+      replica, size = my_client.futures.size(data).result()
+      self.assertEqual(size, len(data))
+      replicas.add(replica)
+    self.assertEqual(replicas, {0, 1})
+    for server in servers:
+      server.Stop()
+
+  def testSerializedValue(self):
+    weights = client.Serialized({'w': np.arange(10), 'b': b'bias'})
+    self.assertGreater(weights.size, 0)
+    self._server.Bind('get_weights', lambda: (1, weights))
+    version, result = self._client.get_weights()
+    self.assertEqual(version, 1)
+    np.testing.assert_array_equal(result['w'], np.arange(10))
+    self.assertEqual(result['b'], b'bias')
+    self.assertEqual(self._client.identity([weights])[0]['b'], b'bias')
+
+  def testCoalescedCalls(self):
+    started = threading.Event()
+    release = threading.Event()
+    calls = []
+
+    def get_params(step):
+      calls.append(step)
+      started.set()
+      release.wait()
+      return step * 10
+
+    self._server.Bind('get_params', get_params, coalesce=True)
+    first = self._client.futures.get_params(1)
+    started.wait()
+    others = [self._client.futures.get_params(1) for _ in range(5)]
+    other_step = self._client.futures.get_params(2)
+    time.sleep(0.1)
+    release.set()
+    self.assertEqual([f.result() for f in [first] + others], [10] * 6)
+    self.assertEqual(other_step.result(), 20)
+    self.assertCountEqual(calls, [1, 2])
+
+  def testResponseCache(self):
+    vocabulary = {'a': 1}
+    calls = []
+
+    def lookup(word):
+      calls.append(word)
+      return vocabulary.get(word)
+
+    self._server.Bind('lookup', lookup, cache=True)
+    self.assertEqual(self._client.lookup('a'), 1)
+    self.assertEqual(self._client.lookup('a'), 1)
+    self.assertEqual(self._client.lookup(word='a'), 1)
+    self.assertEqual(calls, ['a', 'a'])
+    vocabulary['a'] = 2
+    self._server.InvalidateCache('lookup')
+    self.assertEqual(self._client.lookup('a'), 2)
+    self.assertEqual(calls, ['a', 'a', 'a'])
+    # Calls with large arguments are not cached.
+    long_word = 'b' * 100000
+    self.assertIsNone(self._client.lookup(long_word))
+    self.assertIsNone(self._client.lookup(long_word))
+    self.assertEqual(calls, ['a', 'a', 'a', long_word, long_word])
+
   def testClientWaitsUntilServerIsUp(self):
     my_server = py_server.Server()
     my_client = client.Client(my_server.address)
@@ -155,6 +482,21 @@ class PyIntegrationTest(absltest.TestCase):
     self.assertEqual(f.result(), 1000)
     my_server.Stop()
 
+  def testExitWithCallsInFlight(self):
+    # The calls complete while the interpreter shuts down, their results must
+    # not be delivered to it anymore.
+    script = textwrap.dedent(f"""
+        from courier.python import client
+        my_client = client.Client({self._server.address!r})
+        calls = [my_client.futures.slow_method() for _ in range(5)]
+        calls += [my_client.futures.lambda_add(i, 1) for i in range(100)]
+        """)
+    env = dict(os.environ, PYTHONPATH=os.pathsep.join(sys.path))
+    process = subprocess.run([sys.executable, '-c', script],
+                             env=env,
+                             timeout=60)
+    self.assertEqual(process.returncode, 0)
+
   def testClientTimeout(self):
     my_client = client.Client(
         '[::]:12345', call_timeout=datetime.timedelta(seconds=1))
@@ -171,5 +513,42 @@ class PyIntegrationTest(absltest.TestCase):
       my_client_bad.blah()
 
 
+class SerializationTest(absltest.TestCase):
+
+  def _value(self):
+    return {'array': np.arange(10, dtype=np.int32), 'bytes': b'1234'}
+
+  def _assertValueEqual(self, result):
+    np.testing.assert_array_equal(result['array'], self._value()['array'])
+    self.assertEqual(bytes(result['bytes']), b'1234')
+
+  def testSerializeIntoBytearray(self):
+    serialized = serialization.SerializeToString(self._value())
+    buffer = bytearray(len(serialized) + 10)
+    size = serialization.SerializeInto(self._value(), buffer)
+    self.assertEqual(size, len(serialized))
+    self.assertEqual(bytes(buffer[:size]), serialized)
+    self._assertValueEqual(serialization.DeserializeFromString(buffer[:size]))
+
+  def testSerializeIntoTooSmallBuffer(self):
+    buffer = bytearray(4)
+    with self.assertRaisesRegex(StatusNotOk, 'only holds 4'):
+      serialization.SerializeInto(self._value(), buffer)
+    self.assertEqual(buffer, bytearray(4))
+
+  def testDeserializeFromMemoryview(self):
+    serialized = serialization.SerializeToString(self._value())
+    view = memoryview(b'xx' + serialized)[2:]
+    self._assertValueEqual(serialization.DeserializeFromString(view))
+    self._assertValueEqual(
+        serialization.DeserializeFromString(view, bytes_as_memoryview=True))
+
+  def testDeserializeFromMmap(self):
+    serialized = serialization.SerializeToString(self._value())
+    with mmap.mmap(-1, len(serialized)) as mapped:
+      mapped.write(serialized)
+      self._assertValueEqual(serialization.DeserializeFromString(mapped))
+
+
 if __name__ == '__main__':
   absltest.main()
@@ -17,23 +17,37 @@
 #include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/pytypes.h>
+#include <pybind11/stl.h>
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
 
+#include "absl/base/thread_annotations.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "courier/blob_cache.h"
+#include "courier/broadcast.h"
 #include "courier/call_context.h"
 #include "courier/client.h"
+#include "courier/courier_service.pb.h"
 #include "courier/platform/logging.h"
 #include "courier/platform/status_macros.h"
+#include "courier/serialization/array_encoding.h"
 #include "courier/serialization/py_serialize.h"
 #include "courier/serialization/serialization.pb.h"
 #include "pybind11_abseil/absl_casters.h"
@@ -43,13 +57,16 @@ namespace courier {
 
 namespace py = pybind11;
 
-absl::StatusOr<py::object> PyClient::PyCall(
-    const std::string& method, const py::list& args, const py::dict& kwargs,
-    bool wait_for_ready, absl::Duration timeout, bool compress) {
-  auto arguments = std::make_unique<courier::CallArguments>();
-  for (py::handle arg : args) {
+namespace {
+
+absl::StatusOr<std::unique_ptr<courier::CallArguments>> SerializeArguments(
+    const py::list& args, const py::dict& kwargs,
+    const SerializationOptions& options) {
+  auto arguments = absl::make_unique<courier::CallArguments>();
+  for (const py::handle& arg : args) {
     PyObject* object = arg.ptr();
-    COURIER_RETURN_IF_ERROR(SerializePyObject(object, arguments->add_args()));
+    COURIER_RETURN_IF_ERROR(
+        SerializePyObject(object, arguments->add_args(), options));
   }
   for (const auto& kwarg : kwargs) {
     auto ins = arguments->mutable_kwargs()->insert(
@@ -57,82 +74,435 @@ absl::StatusOr<py::object> PyClient::PyCall(
     COURIER_RET_CHECK(ins.second)
         << "Duplicate kwargs key: " << kwarg.first.cast<std::string>();
     PyObject* object = kwarg.second.ptr();
-    COURIER_RETURN_IF_ERROR(SerializePyObject(object, &ins.first->second));
+    COURIER_RETURN_IF_ERROR(
+        SerializePyObject(object, &ins.first->second, options));
+  }
+  return arguments;
+}
+
+absl::StatusOr<SerializationOptions> MakeSerializationOptions(
+    const std::string& float_encoding, const std::string& compression) {
+  SerializationOptions options;
+  COURIER_ASSIGN_OR_RETURN(options.float_encoding,
+                           ParseArrayEncoding(float_encoding));
+  COURIER_ASSIGN_OR_RETURN(options.compression.codec,
+                           ParseCompressionCodec(compression));
+  return options;
+}
+
+// De-serializes the result of a call. With `bytes_as_memoryview`, the result
+// is moved to the heap and kept alive by the returned memoryviews.
+absl::StatusOr<py::object> DeserializeResult(courier::CallResult result,
+                                             bool bytes_as_memoryview) {
+  DeserializationOptions options;
+  const SerializedObject* serialized = &result.result();
+  if (bytes_as_memoryview) {
+    auto owned = std::make_shared<courier::CallResult>(std::move(result));
+    serialized = &owned->result();
+    options.bytes_as_memoryview = true;
+    options.message_owner = std::move(owned);
+  }
+  TensorLookup tensor_lookup;
+  COURIER_ASSIGN_OR_RETURN(
+      courier::SafePyObjectPtr py_object,
+      DeserializePyObject(*serialized, tensor_lookup, options));
+  return py::reinterpret_steal<py::object>(py_object.release());
+}
+
+// Delivers the results of asynchronous calls to Python. Completed calls are
+// queued by the completion queue polling threads, which hence never wait for
+// the GIL, and handed to Python in batches by a dedicated thread so that all
+// completions of a batch share a single acquisition of the GIL.
+class CompletionDispatcher {
+ public:
+  struct Completion {
+    absl::StatusOr<courier::CallResult> result;
+    bool bytes_as_memoryview;
+    PyClient::PyObjectCallback result_cb;
+    PyClient::PyObjectCallback exception_cb;
+  };
+
+  // Returns the dispatcher of the process.
+  static CompletionDispatcher& Get() {
+    // Never destroyed, its thread is stopped by `Stop` at interpreter exit.
+    static auto* dispatcher = new CompletionDispatcher();
+    return *dispatcher;
+  }
+
+  // Queues a completion, starting the dispatching thread on first use.
+  void Add(Completion completion) ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock lock(&mu_);
+    if (stopped_) {
+      // The callbacks hold Python objects which cannot be released without
+      // the GIL once the interpreter is shutting down: leak them.
+      new Completion(std::move(completion));
+      return;
+    }
+    if (!thread_.joinable()) {
+      thread_ = std::thread(&CompletionDispatcher::Run, this);
+    }
+    pending_.push_back(std::move(completion));
+  }
+
+  // Delivers the queued completions and joins the dispatching thread.
+  // Completions added afterwards are dropped. Must be called without the GIL.
+  void Stop() ABSL_LOCKS_EXCLUDED(mu_) {
+    std::thread thread;
+    {
+      absl::MutexLock lock(&mu_);
+      stopped_ = true;
+      thread.swap(thread_);
+    }
+    if (thread.joinable()) thread.join();
   }
+
+ private:
+  CompletionDispatcher() = default;
+
+  bool HasWork() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return stopped_ || !pending_.empty();
+  }
+
+  static bool IsFinalizing() {
+#if PY_VERSION_HEX >= 0x030D0000
+    return Py_IsFinalizing();
+#else
+    return _Py_IsFinalizing();
+#endif
+  }
+
+  void Run() ABSL_LOCKS_EXCLUDED(mu_) {
+    std::vector<Completion> batch;
+    while (true) {
+      {
+        absl::MutexLock lock(&mu_);
+        mu_.Await(absl::Condition(this, &CompletionDispatcher::HasWork));
+        if (pending_.empty()) return;
+        batch.swap(pending_);
+      }
+      if (IsFinalizing()) {
+        // Acquiring the GIL would hang the thread.
+        new std::vector<Completion>(std::move(batch));
+        batch.clear();
+        continue;
+      }
+      py::gil_scoped_acquire gil;
+      for (Completion& completion : batch) {
+        Deliver(&completion);
+      }
+      // The callbacks hold Python objects, release them with the GIL held.
+      batch.clear();
+    }
+  }
+
+  // Invokes the callback of a completion. Requires the GIL.
+  static void Deliver(Completion* completion) {
+    try {
+      if (!completion->result.ok()) {
+        completion->exception_cb(py::cast(
+            py::google::DoNotThrowStatus(completion->result.status())));
+        return;
+      }
+      absl::StatusOr<py::object> py_result =
+          DeserializeResult(std::move(completion->result).value(),
+                            completion->bytes_as_memoryview);
+      if (!py_result.ok()) {
+        completion->exception_cb(
+            py::cast(py::google::DoNotThrowStatus(py_result.status())));
+        return;
+      }
+      completion->result_cb(std::move(py_result).value());
+    } catch (py::error_already_set& e) {
+      // A failing callback must not prevent the delivery of the others.
+      e.restore();
+      PyErr_Print();
+    }
+  }
+
+  absl::Mutex mu_;
+  std::vector<Completion> pending_ ABSL_GUARDED_BY(mu_);
+  bool stopped_ ABSL_GUARDED_BY(mu_) = false;
+  std::thread thread_ ABSL_GUARDED_BY(mu_);
+};
+
+// Calls a method with the same arguments on several clients, serializing the
+// arguments once. The outcome of the i-th call is passed to `result_cbs[i]`
+// or `exception_cbs[i]`.
+absl::StatusOr<std::vector<PyClientCallCanceller>> PyBroadcast(
+    const std::vector<PyClient*>& clients, const std::string& method,
+    const py::list& args, const py::dict& kwargs,
+    std::vector<PyClient::PyObjectCallback> result_cbs,
+    std::vector<PyClient::PyObjectCallback> exception_cbs, bool wait_for_ready,
+    absl::Duration timeout, bool compress, const std::string& float_encoding,
+    const std::string& compression, bool bytes_as_memoryview) {
+  COURIER_RET_CHECK(result_cbs.size() == clients.size() &&
+                    exception_cbs.size() == clients.size())
+      << "Expected one result and one exception callback per client.";
+  COURIER_ASSIGN_OR_RETURN(
+      SerializationOptions options,
+      MakeSerializationOptions(float_encoding, compression));
+  COURIER_ASSIGN_OR_RETURN(auto arguments,
+                           SerializeArguments(args, kwargs, options));
+  BroadcastOptions broadcast_options;
+  broadcast_options.timeout = timeout;
+  broadcast_options.wait_for_ready = wait_for_ready;
+  broadcast_options.compress = compress;
+  // Each callback is moved out exactly once, by the completion of its call.
+  auto callbacks = std::make_shared<
+      std::pair<std::vector<PyClient::PyObjectCallback>,
+                std::vector<PyClient::PyObjectCallback>>>(
+      std::move(result_cbs), std::move(exception_cbs));
+  std::vector<Client*> base_clients(clients.begin(), clients.end());
+
+  // Release the GIL as the clients might block on `Client::Init()`.
+  PyThreadState* thread_state = PyEval_SaveThread();
+  std::vector<std::shared_ptr<CallContext>> contexts = AsyncBroadcastF(
+      base_clients, method, std::move(arguments), broadcast_options,
+      [callbacks, bytes_as_memoryview](
+          int i, absl::StatusOr<courier::CallResult> result_or) {
+        CompletionDispatcher::Get().Add(
+            {std::move(result_or), bytes_as_memoryview,
+             std::move(callbacks->first[i]), std::move(callbacks->second[i])});
+      });
+  PyEval_RestoreThread(thread_state);
+  std::vector<PyClientCallCanceller> cancellers;
+  cancellers.reserve(contexts.size());
+  for (std::shared_ptr<CallContext>& context : contexts) {
+    cancellers.emplace_back(
+        [context = std::move(context)] { context->Cancel(); });
+  }
+  return cancellers;
+}
+
+}  // namespace
+
+absl::StatusOr<py::object> PyClient::PyCall(
+    const std::string& method, const py::list& args, const py::dict& kwargs,
+    bool wait_for_ready, absl::Duration timeout, bool compress,
+    const std::string& float_encoding, const std::string& compression,
+    bool chunked, bool bytes_as_memoryview) {
+  COURIER_ASSIGN_OR_RETURN(
+      SerializationOptions options,
+      MakeSerializationOptions(float_encoding, compression));
+  COURIER_ASSIGN_OR_RETURN(auto arguments,
+                           SerializeArguments(args, kwargs, options));
   PyThreadState* thread_state = PyEval_SaveThread();
   CallContext context(timeout, /*wait_for_ready=*/wait_for_ready,
                       /*compress=*/compress, /*interruptible=*/true);
   absl::StatusOr<courier::CallResult> result_or =
-      CallF(&context, method, std::move(arguments));
+      chunked ? ChunkedCallF(&context, method, std::move(arguments))
+              : CallF(&context, method, std::move(arguments));
   PyEval_RestoreThread(thread_state);
   COURIER_ASSIGN_OR_RETURN(courier::CallResult result, std::move(result_or));
-  COURIER_ASSIGN_OR_RETURN(courier::SafePyObjectPtr py_object,
-                           DeserializePyObject(result.result()));
-  return py::reinterpret_steal<py::object>(py_object.release());
+  return DeserializeResult(std::move(result), bytes_as_memoryview);
 }
 
 absl::StatusOr<PyClientCallCanceller> PyClient::AsyncPyCall(
     const std::string& method, const py::list& args, const py::dict& kwargs,
     PyObjectCallback result_cb, PyObjectCallback exception_cb,
-    bool wait_for_ready, absl::Duration timeout, bool compress) {
-  auto arguments = absl::make_unique<courier::CallArguments>();
-  for (const py::handle& arg : args) {
-    PyObject* object = arg.ptr();
-    COURIER_RETURN_IF_ERROR(SerializePyObject(object, arguments->add_args()));
-  }
-  for (const auto& kwarg : kwargs) {
-    auto ins = arguments->mutable_kwargs()->insert(
-        {kwarg.first.cast<std::string>(), courier::SerializedObject()});
-    COURIER_RET_CHECK(ins.second)
-        << "Duplicate kwargs key: " << kwarg.first.cast<std::string>();
-    PyObject* object = kwarg.second.ptr();
-    COURIER_RETURN_IF_ERROR(SerializePyObject(object, &ins.first->second));
+    bool wait_for_ready, absl::Duration timeout, bool compress,
+    const std::string& float_encoding, const std::string& compression,
+    bool bytes_as_memoryview) {
+  return StartAsyncPyCall(
+      method, args, kwargs, wait_for_ready, timeout, compress, float_encoding,
+      compression,
+      [exception_cb = std::move(exception_cb), result_cb = std::move(result_cb),
+       bytes_as_memoryview](
+          absl::StatusOr<courier::CallResult> result_or) mutable {
+        CompletionDispatcher::Get().Add(
+            {std::move(result_or), bytes_as_memoryview, std::move(result_cb),
+             std::move(exception_cb)});
+      });
+}
+
+absl::StatusOr<PyClientCallCanceller> PyClient::QueuedPyCall(
+    const std::string& method, const py::list& args, const py::dict& kwargs,
+    std::shared_ptr<PyCompletionQueue> queue, int64_t tag,
+    bool wait_for_ready, absl::Duration timeout, bool compress,
+    const std::string& float_encoding, const std::string& compression,
+    bool bytes_as_memoryview) {
+  return StartAsyncPyCall(
+      method, args, kwargs, wait_for_ready, timeout, compress, float_encoding,
+      compression,
+      [queue = std::move(queue), tag,
+       bytes_as_memoryview](absl::StatusOr<courier::CallResult> result_or) {
+        queue->Add(tag, std::move(result_or), bytes_as_memoryview);
+      });
+}
+
+absl::StatusOr<PyClientCallCanceller> PyClient::StartAsyncPyCall(
+    const std::string& method, const py::list& args, const py::dict& kwargs,
+    bool wait_for_ready, absl::Duration timeout, bool compress,
+    const std::string& float_encoding, const std::string& compression,
+    std::function<void(absl::StatusOr<courier::CallResult>)> callback) {
+  COURIER_ASSIGN_OR_RETURN(
+      SerializationOptions options,
+      MakeSerializationOptions(float_encoding, compression));
+  COURIER_ASSIGN_OR_RETURN(auto arguments,
+                           SerializeArguments(args, kwargs, options));
+  if (batcher_) {
+    batcher_->AsyncCallF(method, std::move(arguments), std::move(callback));
+    return PyClientCallCanceller([] {});
   }
   auto context = std::make_shared<CallContext>(
       timeout, /*wait_for_ready=*/wait_for_ready, /*compress=*/compress,
       /*interruptible=*/true);
   // Release the GIL as `AsynCallF` might block on `Client::Init()`.
   PyThreadState* thread_state = PyEval_SaveThread();
-  AsyncCallF(
-      context.get(), method, std::move(arguments),
-      [exception_cb = std::move(exception_cb), result_cb = std::move(result_cb),
-       context](const absl::StatusOr<courier::CallResult>& result_or) {
-        py::gil_scoped_acquire gil;
-        if (!result_or.ok()) {
-          exception_cb(
-              py::cast(py::google::DoNotThrowStatus(result_or.status())));
-          return;
-        }
-        const courier::CallResult& result = result_or.value();
-        absl::StatusOr<courier::SafePyObjectPtr> py_result =
-            DeserializePyObject(result.result());
-        if (!py_result.ok()) {
-          exception_cb(
-              py::cast(py::google::DoNotThrowStatus(py_result.status())));
-          return;
-        }
-        result_cb(
-            py::reinterpret_steal<py::object>(py_result.value().release()));
-      });
+  AsyncCallF(context.get(), method, std::move(arguments),
+             [callback = std::move(callback),
+              context](absl::StatusOr<courier::CallResult> result_or) {
+               callback(std::move(result_or));
+             });
 
   PyEval_RestoreThread(thread_state);
   return PyClientCallCanceller([context] { context->Cancel(); });
 }
 
+void PyClient::EnableBatching(int max_batch_size, absl::Duration max_delay,
+                              bool wait_for_ready, absl::Duration timeout,
+                              bool compress) {
+  CallBatcherOptions options;
+  options.max_batch_size = max_batch_size;
+  options.max_delay = max_delay;
+  options.wait_for_ready = wait_for_ready;
+  options.timeout = timeout;
+  options.compress = compress;
+  batcher_ = absl::make_unique<CallBatcher>(this, options);
+}
+
+PyCompletionQueue::PyCompletionQueue()
+    : fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+  COURIER_CHECK(fd_ >= 0) << "Failed to create eventfd: " << strerror(errno);
+}
+
+PyCompletionQueue::~PyCompletionQueue() { close(fd_); }
+
+void PyCompletionQueue::Add(int64_t tag,
+                            absl::StatusOr<courier::CallResult> result,
+                            bool bytes_as_memoryview) {
+  absl::MutexLock lock(&mu_);
+  // Only signal the first of the results queued since the last `Drain`, the
+  // event loop fetches all of them at once.
+  if (pending_.empty()) {
+    uint64_t value = 1;
+    COURIER_CHECK(write(fd_, &value, sizeof(value)) == sizeof(value))
+        << "Failed to signal eventfd: " << strerror(errno);
+  }
+  pending_.push_back({tag, std::move(result), bytes_as_memoryview});
+}
+
+py::list PyCompletionQueue::Drain() {
+  // Reset the eventfd before taking the results, results added after this
+  // point are signalled again.
+  uint64_t value;
+  if (read(fd_, &value, sizeof(value)) < 0) {
+    COURIER_CHECK(errno == EAGAIN)
+        << "Failed to read eventfd: " << strerror(errno);
+  }
+  std::vector<Completion> batch;
+  {
+    absl::MutexLock lock(&mu_);
+    batch.swap(pending_);
+  }
+  py::list results;
+  for (Completion& completion : batch) {
+    absl::StatusOr<py::object> py_result =
+        completion.result.ok()
+            ? DeserializeResult(std::move(completion.result).value(),
+                                completion.bytes_as_memoryview)
+            : absl::StatusOr<py::object>(completion.result.status());
+    if (py_result.ok()) {
+      results.append(
+          py::make_tuple(completion.tag, true, std::move(py_result).value()));
+    } else {
+      results.append(py::make_tuple(
+          completion.tag, false,
+          py::cast(py::google::DoNotThrowStatus(py_result.status()))));
+    }
+  }
+  return results;
+}
+
 namespace {
 
 PYBIND11_MODULE(py_client, m) {
   py::google::ImportStatusModule();
 
+  // Delivers the pending completions while the interpreter is still fully
+  // alive, the dispatching thread must not acquire the GIL past this point.
+  py::module::import("atexit").attr("register")(py::cpp_function([]() {
+    py::gil_scoped_release release;
+    CompletionDispatcher::Get().Stop();
+  }));
+
   py::class_<PyClientCallCanceller>(m, "PyClientCallCanceller")
       .def("Cancel", &PyClientCallCanceller::Cancel);
 
+  py::class_<PyCompletionQueue, std::shared_ptr<PyCompletionQueue>>(
+      m, "PyCompletionQueue")
+      .def(py::init<>())
+      .def("fileno", &PyCompletionQueue::fileno)
+      .def("Drain", &PyCompletionQueue::Drain);
+
+  py::class_<Subscription>(m, "PySubscription")
+      .def("Next",
+           [](Subscription& subscription) -> absl::StatusOr<py::tuple> {
+             absl::StatusOr<SubscribeResponse> response_or;
+             {
+               py::gil_scoped_release nogil;
+               response_or = subscription.Next();
+             }
+             COURIER_ASSIGN_OR_RETURN(SubscribeResponse response,
+                                      std::move(response_or));
+             COURIER_ASSIGN_OR_RETURN(courier::SafePyObjectPtr value,
+                                      DeserializePyObject(response.value()));
+             return py::make_tuple(
+                 response.version(),
+                 py::reinterpret_steal<py::object>(value.release()));
+           })
+      .def("Cancel", &Subscription::Cancel);
+
   py::class_<PyClient, std::shared_ptr<PyClient>>(m, "PyClient")
-      .def(py::init<const std::string&>())
+      .def(py::init<const std::string&, int, int>())
+      .def(py::init<std::vector<std::string>, int, int>())
       .def("PyCall", &PyClient::PyCall)
       .def("AsyncPyCall", &PyClient::AsyncPyCall)
+      .def("QueuedPyCall", &PyClient::QueuedPyCall)
+      .def("EnableBatching", &PyClient::EnableBatching)
+      .def("EnableHedging",
+           [](PyClient& client, std::vector<std::string> methods,
+              absl::Duration delay, double latency_percentile) {
+             HedgingPolicy policy;
+             policy.methods = std::move(methods);
+             policy.delay = delay;
+             policy.latency_percentile = latency_percentile;
+             client.EnableHedging(policy);
+           })
+      .def("EnableBlobCache",
+           [](PyClient& client, int64_t min_blob_size) {
+             BlobCacheOptions options;
+             options.min_blob_size = min_blob_size;
+             client.EnableBlobCache(options);
+           })
+      .def("RetryStats",
+           [](const PyClient& client) {
+             RetryStats stats = client.retry_stats();
+             py::dict result;
+             result["retries"] = stats.retries;
+             result["budget_exhausted"] = stats.budget_exhausted;
+             return result;
+           })
       .def("ListMethods", &PyClient::ListMethods,
-           py::call_guard<py::gil_scoped_release>());
+           py::call_guard<py::gil_scoped_release>())
+      // The subscription keeps the client alive.
+      .def("Subscribe", &PyClient::Subscribe, py::keep_alive<0, 1>());
+
+  m.def("Broadcast", &PyBroadcast);
+  m.attr("Serialized") = py::reinterpret_borrow<py::object>(
+      reinterpret_cast<PyObject*>(SerializedValueType()));
+  m.attr("_serialized_value_type") =
+      py::reinterpret_steal<py::object>(NewSerializedValueTypeCapsule());
 }
 
 }  // namespace
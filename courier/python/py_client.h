@@ -17,14 +17,20 @@
 
 #include <pybind11/pybind11.h>
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "courier/call_batcher.h"
 #include "courier/client.h"
+#include "courier/serialization/serialization.pb.h"
 #include <pybind11/pybind11.h>
 
 namespace courier {
@@ -42,6 +48,43 @@ class PyClientCallCanceller {
   std::function<void()> fn_;
 };
 
+// Collects the results of asynchronous calls for a Python event loop.
+// Completed calls are queued by the polling threads, which signal the
+// availability of new results on an eventfd the event loop listens to. The
+// event loop then fetches all results at once with `Drain`. Thread-safe.
+class PyCompletionQueue {
+ public:
+  PyCompletionQueue();
+  ~PyCompletionQueue();
+
+  PyCompletionQueue(const PyCompletionQueue&) = delete;
+  PyCompletionQueue& operator=(const PyCompletionQueue&) = delete;
+
+  // File descriptor which becomes readable when results are available.
+  int fileno() const { return fd_; }
+
+  // Queues the result of the call identified by `tag`.
+  void Add(int64_t tag, absl::StatusOr<courier::CallResult> result,
+           bool bytes_as_memoryview) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns a `(tag, ok, value)` tuple for every call which completed since
+  // the last call to `Drain`. `value` is the de-serialized result if `ok`,
+  // the error status otherwise. Requires the GIL.
+  pybind11::list Drain() ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Completion {
+    int64_t tag;
+    absl::StatusOr<courier::CallResult> result;
+    bool bytes_as_memoryview;
+  };
+
+  const int fd_;
+
+  absl::Mutex mu_;
+  std::vector<Completion> pending_ ABSL_GUARDED_BY(mu_);
+};
+
 // PyClient implements a Python interface for Client.
 //
 // Python example:
@@ -59,22 +102,67 @@ class PyClient : public Client {
   // Calls a method on the server with a list of arguments.
   // The result from calling the method will be returned as a Python object.
   // A non-zero `timeout` will be used as the timeout for the RPC call.
+  // A non-empty `float_encoding` names the `EncodedArray::Encoding` used to
+  // transport float arrays in the arguments. A non-empty `compression` names
+  // the `Compression::Codec` applied to numpy arrays in the arguments. If
+  // `chunked` is set, the call is made with `ChunkedCallF`. If
+  // `bytes_as_memoryview` is set, bytes in the result are returned as
+  // memoryviews over the received message instead of being copied.
   absl::StatusOr<pybind11::object> PyCall(const std::string& method,
                                           const pybind11::list& args,
                                           const pybind11::dict& kwargs,
                                           bool wait_for_ready,
                                           absl::Duration timeout,
-                                          bool compress);
+                                          bool compress,
+                                          const std::string& float_encoding,
+                                          const std::string& compression,
+                                          bool chunked,
+                                          bool bytes_as_memoryview);
 
   // Asynchronous variant of PyCall.
   // A non-zero `timeout` will be used as the timeout for the RPC call.
   // Returns a function to cancel the call. Calling this function after the call
   // has finished is legal and results in a no-op.
+  // The callbacks are invoked on a thread shared by all clients, together
+  // with those of other calls that completed meanwhile.
   absl::StatusOr<PyClientCallCanceller> AsyncPyCall(
       const std::string& method, const pybind11::list& args,
       const pybind11::dict& kwargs, PyObjectCallback result_cb,
       PyObjectCallback exception_cb, bool wait_for_ready,
-      absl::Duration timeout, bool compress);
+      absl::Duration timeout, bool compress,
+      const std::string& float_encoding, const std::string& compression,
+      bool bytes_as_memoryview);
+
+  // Variant of AsyncPyCall for event loops. The result is added to `queue`
+  // under `tag` rather than passed to a callback.
+  absl::StatusOr<PyClientCallCanceller> QueuedPyCall(
+      const std::string& method, const pybind11::list& args,
+      const pybind11::dict& kwargs, std::shared_ptr<PyCompletionQueue> queue,
+      int64_t tag, bool wait_for_ready, absl::Duration timeout, bool compress,
+      const std::string& float_encoding, const std::string& compression,
+      bool bytes_as_memoryview);
+
+  // Sends the asynchronous calls of the client in `BatchCall` RPCs of up to
+  // `max_batch_size` calls, waiting at most `max_delay` for a batch to fill.
+  // `wait_for_ready`, `timeout` and `compress` then apply to the batches
+  // instead of the individual calls, which can no longer be cancelled. Must
+  // be called before the first call.
+  void EnableBatching(int max_batch_size, absl::Duration max_delay,
+                      bool wait_for_ready, absl::Duration timeout,
+                      bool compress);
+
+ private:
+  // Serializes the arguments and starts an asynchronous call invoking
+  // `callback` on completion.
+  absl::StatusOr<PyClientCallCanceller> StartAsyncPyCall(
+      const std::string& method, const pybind11::list& args,
+      const pybind11::dict& kwargs, bool wait_for_ready,
+      absl::Duration timeout, bool compress,
+      const std::string& float_encoding, const std::string& compression,
+      std::function<void(absl::StatusOr<courier::CallResult>)> callback);
+
+  // Set if asynchronous calls are batched.
+  std::unique_ptr<CallBatcher> batcher_;
 };
 
 }  // namespace courier
@@ -23,12 +23,15 @@ client = courier.Client('my_server')
 result = client.my_function(4, 7)  # 11, evaluated on the server.
 """
 
-from typing import Optional
+import datetime
+from typing import Any, Optional, Union
 
 
 from courier.handlers.python import pybind
 from courier.python import router
 from courier.python import server
+from courier.python import versioning
+import numpy as np
 import portpicker
 from six.moves import map
 import tree as nest
@@ -68,8 +71,98 @@ class Server:
   def address(self) -> str:
     return f'localhost:{self._port}'
 
-  def Bind(self, method_name: str, py_func):
-    self._router.Bind(method_name, pybind.BuildPyCallHandler(py_func))
+  def Bind(self,
+           method_name: str,
+           py_func,
+           float_encoding: Optional[str] = None,
+           compression: Optional[str] = None,
+           versioned: bool = False,
+           coalesce: bool = False,
+           cache: bool = False,
+           cache_ttl: Optional[Union[int, float, datetime.timedelta]] = None,
+           cache_max_entries: int = 1024):
+    """Binds `py_func` to `method_name`.
+
+    Args:
+      method_name: Name under which clients call the method.
+      py_func: Python callable which is executed for each call.
+      float_encoding: If set, float32 and float64 numpy arrays in the results
+        are down-cast for transport. See `courier.Client` for the options.
+      compression: If set, numpy arrays in the results are compressed with
+        this codec. See `courier.Client` for the options.
+      versioned: If set, `courier.VersionedPull` only receives the leaves of
+        the (nested) result which changed since its previous call. The result
+        must not depend on the call arguments.
+      coalesce: If set, concurrent calls with identical arguments share a
+        single execution of `py_func` and the serialization of its result.
+        Calls with arguments above 64 KiB are not coalesced. Only for methods
+        without side effects.
+      cache: If set, results are cached by call arguments and calls with the
+        same arguments are answered from the cache without calling `py_func`.
+        Calls with arguments above 64 KiB are not cached. Only for methods
+        without side effects. See `InvalidateCache`.
+      cache_ttl: If set, cached results expire after this long, in seconds if
+        a number. Otherwise they are kept until invalidated.
+      cache_max_entries: Maximum number of distinct arguments whose results
+        are cached. The least recently used ones are dropped first.
+    """
+    if versioned:
+      py_func = versioning.VersionedFunction(py_func)
+    handler = pybind.BuildPyCallHandler(py_func, float_encoding or '',
+                                        compression or '')
+    if coalesce:
+      handler = pybind.CoalesceCalls(handler)
+    self._router.Bind(method_name, handler)
+    if cache:
+      if cache_ttl is None:
+        cache_ttl = datetime.timedelta(0)
+      elif not isinstance(cache_ttl, datetime.timedelta):
+        cache_ttl = datetime.timedelta(seconds=cache_ttl)
+      self._router.EnableResponseCache(method_name, cache_ttl,
+                                       cache_max_entries)
+
+  def BindBatched(self,
+                  method_name: str,
+                  py_func,
+                  max_batch_size: int,
+                  max_latency: Union[int, float, datetime.timedelta] = 0.001,
+                  float_encoding: Optional[str] = None,
+                  compression: Optional[str] = None):
+    """Binds `py_func` to `method_name` with calls executed in batches.
+
+    Concurrent calls are gathered until `max_batch_size` of them are waiting
+    or the oldest one has waited `max_latency`. Their arguments are stacked
+    into numpy arrays with a new leading axis, so all calls of a batch must
+    pass arguments of the same structure and shapes. `py_func` is executed
+    once per batch and must return a (nest of) array(s) with the same leading
+    dimension, which is split back into the results of the individual calls.
+
+    Args:
+      method_name: Name under which clients call the method.
+      py_func: Python callable which is executed for each batch of calls.
+      max_batch_size: Maximum number of calls in a batch.
+      max_latency: Maximum time a call waits for its batch to fill up, in
+        seconds if a number.
+      float_encoding: See `Bind`.
+      compression: See `Bind`.
+    """
+
+    def batched_func(calls):
+      args, kwargs = nest.map_structure(lambda *values: np.stack(values),
+                                        *calls)
+      result = py_func(*args, **kwargs)
+      return [
+          nest.map_structure(lambda value: value[i], result)
+          for i in range(len(calls))
+      ]
+
+    if not isinstance(max_latency, datetime.timedelta):
+      max_latency = datetime.timedelta(seconds=max_latency)
+    self._router.Bind(
+        method_name,
+        pybind.BuildPyBatchedCallHandler(batched_func, max_batch_size,
+                                         max_latency, float_encoding or '',
+                                         compression or ''))
 
 
   def Join(self):
@@ -95,6 +188,33 @@ class Server:
   def Unbind(self, method_name):
     self._router.Unbind(method_name)
 
+  def InvalidateCache(self, method_name: Optional[str] = None):
+    """Drops the cached results of a method bound with `cache=True`.
+
+    Must be called when the state the results depend on changes. Calls in
+    flight do not cache their results.
+
+    Args:
+      method_name: Name of the method. If not set, drops the cached results of
+        all methods.
+    """
+    self._router.InvalidateResponseCache(method_name or '')
+
+  def Publish(self, topic: str, value: Any) -> int:
+    """Publishes a new version of a value to the subscribers of `topic`.
+
+    Subscribers which have not read the previous version yet skip it. See
+    `courier.subscribe`.
+
+    Args:
+      topic: Name of the value.
+      value: The new version of the value.
+
+    Returns:
+      The number of the new version, starting at one.
+    """
+    return self._router.Publish(topic, value)
+
   @property
   def has_started(self):
     """Returns True if the method `Start` has already been called.
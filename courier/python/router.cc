@@ -17,6 +17,11 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/pytypes.h>
 
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "courier/platform/status_macros.h"
+#include "courier/serialization/py_serialize.h"
+#include "courier/serialization/serialization.pb.h"
 #include "pybind11_abseil/absl_casters.h"
 #include "pybind11_abseil/status_casters.h"
 
@@ -44,7 +49,27 @@ PYBIND11_MODULE(router, m) {
       m, "Router")
       .def(py::init<>())
       .def("Bind", &Router::Bind)
-      .def("Unbind", &Router::Unbind, py::call_guard<py::gil_scoped_release>());
+      .def("Unbind", &Router::Unbind, py::call_guard<py::gil_scoped_release>())
+      .def("Publish",
+           [](Router& router, const std::string& topic,
+              py::handle value) -> absl::StatusOr<int64_t> {
+             COURIER_ASSIGN_OR_RETURN(SerializedObject serialized,
+                                      SerializePyObject(value.ptr()));
+             py::gil_scoped_release nogil;
+             return router.publisher()->Publish(topic, std::move(serialized));
+           })
+      .def("EnableResponseCache",
+           [](Router& router, const std::string& method, absl::Duration ttl,
+              int64_t max_entries) {
+             router.response_cache()->Enable(
+                 method, ttl > absl::ZeroDuration() ? ttl
+                                                    : absl::InfiniteDuration(),
+                 max_entries);
+           })
+      .def("InvalidateResponseCache",
+           [](Router& router, const std::string& method) {
+             router.response_cache()->Invalidate(method);
+           });
 }
 
 }  // namespace
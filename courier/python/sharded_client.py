@@ -0,0 +1,227 @@
+# Copyright 2020 DeepMind Technologies Limited. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Client of a service whose state is partitioned across several servers.
+
+Example usage:
+client = courier.ShardedClient(['shard_0', 'shard_1', 'shard_2'])
+client.insert('some_key', value)  # Goes to the shard owning 'some_key'.
+values = client.call_multi('lookup', ['key_1', 'key_2', 'key_3'])
+"""
+
+import bisect
+import hashlib
+import operator
+from typing import Any, Callable, Dict, Hashable, List, Optional, Sequence
+
+from courier.python import client as courier_client
+
+
+def _hash(value: bytes) -> int:
+  return int.from_bytes(
+      hashlib.blake2b(value, digest_size=8).digest(), byteorder='little')
+
+
+def _normalize_key(key: Hashable) -> Hashable:
+  """Converts a key to built-in types, e.g. `np.int64(5)` to `5`."""
+  if isinstance(key, bytes):
+    return bytes(key)
+  if isinstance(key, str):
+    return str(key)
+  if isinstance(key, tuple):
+    return tuple(_normalize_key(item) for item in key)
+  try:
+    return operator.index(key)
+  except TypeError:
+    raise TypeError(
+        f'Unsupported key type {type(key).__name__}: keys must be bytes, '
+        'strings, integers or tuples of those.') from None
+
+
+def _key_bytes(key: Hashable) -> bytes:
+  key = _normalize_key(key)
+  if isinstance(key, bytes):
+    return key
+  if isinstance(key, str):
+    return key.encode('utf-8')
+  # Unlike `hash`, the `repr` of built-in integers and tuples is the same in
+  # every process.
+  return repr(key).encode('utf-8')
+
+
+class ConsistentHashRing:
+  """Maps keys to shards such that adding or removing a shard only moves the
+  keys of that shard.
+
+  Every shard owns `num_virtual_nodes` points on a ring of hashes, derived
+  from its name. A key belongs to the shard owning the first point at or
+  after the hash of the key.
+  """
+
+  def __init__(self, shard_names: Sequence[str], num_virtual_nodes: int = 100):
+    points = []
+    for shard, name in enumerate(shard_names):
+      for node in range(num_virtual_nodes):
+        points.append((_hash(f'{name}#{node}'.encode('utf-8')), shard))
+    points.sort()
+    self._hashes = [point for point, _ in points]
+    self._shards = [shard for _, shard in points]
+
+  def shard(self, key: Hashable) -> int:
+    """Returns the index of the shard owning `key`."""
+    i = bisect.bisect_left(self._hashes, _hash(_key_bytes(key)))
+    return self._shards[i % len(self._shards)]
+
+
+def _first_argument(*args, **kwargs):
+  del kwargs
+  return args[0]
+
+
+class _ShardedFutures:
+  """Asynchronous interface of a `ShardedClient`."""
+
+  def __init__(self, sharded_client: 'ShardedClient'):
+    self._sharded_client = sharded_client
+
+  def __getattr__(self, method: str):
+    client = self._sharded_client
+
+    def call(*args, **kwargs):
+      shard = client.shard(client.key_fn(*args, **kwargs))
+      return getattr(client.shards[shard].futures, method)(*args, **kwargs)
+
+    return call
+
+
+class ShardedClient:
+  """Routes calls to the shards of a partitioned service by key.
+
+  Calls made as attributes of the client (`client.method(...)` or
+  `client.futures.method(...)`) go to the shard owning the key which
+  `key_fn` extracts from their arguments. By default, the key is the first
+  positional argument. `call_multi` splits calls over several keys by shard.
+  """
+
+  def __init__(self,
+               server_addresses: Sequence[str],
+               key_fn: Optional[Callable[..., Hashable]] = None,
+               num_virtual_nodes: int = 100,
+               **client_kwargs):
+    """Initiates a client for each shard.
+
+    Args:
+      server_addresses: Addresses of the shards. The address of a shard also
+        determines which keys it owns, so that keys only move between shards
+        when a shard is added or removed.
+      key_fn: Called with the arguments of a call, returns the key which
+        determines the shard. Keys must be bytes, strings, integers
+        (including numpy integers, which hash like the equal `int`) or tuples
+        of those, other keys raise a `TypeError`.
+      num_virtual_nodes: Number of points of every shard on the hash ring.
+        More points spread the keys more evenly.
+      **client_kwargs: Passed to the `Client` of every shard.
+    """
+    if not server_addresses:
+      raise ValueError('At least one server address is required.')
+    self._init_args = (list(server_addresses), key_fn, num_virtual_nodes)
+    self._client_kwargs = client_kwargs
+    self._shards = [
+        courier_client.Client(address, **client_kwargs)
+        for address in server_addresses
+    ]
+    self._ring = ConsistentHashRing(
+        [str(address) for address in server_addresses], num_virtual_nodes)
+    self._key_fn = key_fn or _first_argument
+    self._futures = _ShardedFutures(self)
+
+  def __reduce__(self):
+    return _build_sharded_client, self._init_args + (self._client_kwargs,)
+
+  @property
+  def shards(self) -> List[courier_client.Client]:
+    """Gets the clients of the shards, in the order of their addresses."""
+    return self._shards
+
+  @property
+  def key_fn(self) -> Callable[..., Hashable]:
+    return self._key_fn
+
+  @property
+  def futures(self) -> _ShardedFutures:
+    """Gets an asynchronous client on which a method call returns a future."""
+    return self._futures
+
+  def shard(self, key: Hashable) -> int:
+    """Returns the index of the shard owning `key`."""
+    return self._ring.shard(key)
+
+  def call_multi(self, method: str, keys: Sequence[Hashable], *args,
+                 **kwargs) -> List[Any]:
+    """Calls a method taking a list of keys on the shards owning them.
+
+    `method(shard_keys, *args, **kwargs)` is called concurrently on every shard
+    owning some of `keys`, with the keys it owns. It must return one result
+    per key. The results are merged back in the order of `keys`.
+
+    Args:
+      method: Name of the method.
+      keys: Keys of the call.
+      *args: Further arguments passed to every sub-call.
+      **kwargs: Keyword arguments passed to every sub-call.
+
+    Returns:
+      The list of results, one per key.
+    """
+    positions: Dict[int, List[int]] = {}
+    for i, key in enumerate(keys):
+      positions.setdefault(self._ring.shard(key), []).append(i)
+    calls = {
+        shard: getattr(self._shards[shard].futures, method)(
+            [keys[i] for i in shard_positions], *args, **kwargs)
+        for shard, shard_positions in positions.items()
+    }
+    results = [None] * len(keys)
+    for shard, call in calls.items():
+      shard_results = call.result()
+      shard_positions = positions[shard]
+      if len(shard_results) != len(shard_positions):
+        raise ValueError(
+            f'Method {method} returned {len(shard_results)} results for '
+            f'{len(shard_positions)} keys on shard {shard}.')
+      for i, result in zip(shard_positions, shard_results):
+        results[i] = result
+    return results
+
+  def __getattr__(self, method: str):
+    """Gets a callable function for the method, routed by key.
+
+    Args:
+      method: Name of the method.
+
+    Returns:
+      Callable function for the method.
+    """
+
+    def call(*args, **kwargs):
+      shard = self._ring.shard(self._key_fn(*args, **kwargs))
+      return getattr(self._shards[shard], method)(*args, **kwargs)
+
+    return call
+
+
+def _build_sharded_client(server_addresses, key_fn, num_virtual_nodes,
+                          client_kwargs):
+  return ShardedClient(server_addresses, key_fn, num_virtual_nodes,
+                       **client_kwargs)
@@ -0,0 +1,186 @@
+# Copyright 2020 DeepMind Technologies Limited. All rights reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Delta transfers of large nests of values, such as model parameters.
+
+Example usage:
+server.Bind('get_params', learner.get_params, versioned=True)
+
+pull = courier.VersionedPull(client, 'get_params')
+params = pull()  # The full nest.
+params = pull()  # Only the leaves which changed are transferred.
+
+The server keeps a content hash and a version stamp for every leaf of the
+last result of a versioned method. A `VersionedPull` sends the version it
+holds and receives the leaves which changed since then, which it merges into
+its cached copy. Regular calls of a versioned method return the full result.
+"""
+
+import hashlib
+import os
+import threading
+from typing import Any, Dict, List, Optional, Tuple
+
+import numpy as np
+import tree as nest
+
+# Keyword argument through which a `VersionedPull` sends the version it holds.
+KNOWN_VERSION_KWARG = '_courier_known_version'
+
+
+def _digest(leaf: Any) -> Optional[bytes]:
+  """Returns a hash of the content of `leaf`, None if it cannot be hashed."""
+  if isinstance(leaf, (bytes, str, int, float, bool, type(None))):
+    return hashlib.blake2b(
+        f'{type(leaf).__name__}:{leaf!r}'.encode('utf-8')).digest()
+  if isinstance(leaf, np.ndarray) or hasattr(leaf, '__array__'):
+    array = np.asarray(leaf)
+    if array.dtype.hasobject:
+      return None
+    h = hashlib.blake2b(f'{array.dtype.str}{array.shape}'.encode('utf-8'))
+    h.update(np.ascontiguousarray(array).reshape(-1).view(np.uint8))
+    return h.digest()
+  return None
+
+
+class VersionedFunction:
+  """Wraps the function of a versioned method.
+
+  Every call of the function is diffed against its previous result: leaves
+  whose content changed get a new version stamp. The result of a call made
+  with a known version only holds the leaves stamped after that version.
+  Results must not depend on the call arguments, since all callers share the
+  version history.
+  """
+
+  def __init__(self, func):
+    self._func = func
+    self._lock = threading.Lock()
+    # Distinguishes the version histories of different servers and of
+    # restarts of the same server.
+    self._epoch = int.from_bytes(os.urandom(7), byteorder='little')
+    self._version = 0
+    self._structure = None
+    self._structure_version = 0
+    self._leaves: List[Any] = []
+    self._digests: List[Optional[bytes]] = []
+    self._leaf_versions: List[int] = []
+
+  def __call__(self, *args, **kwargs):
+    known = kwargs.pop(KNOWN_VERSION_KWARG, None)
+    result = self._func(*args, **kwargs)
+    if known is None:
+      return result
+    leaves = nest.flatten(result)
+    digests = [_digest(leaf) for leaf in leaves]
+    skeleton = nest.map_structure(lambda _: 0, result)
+    with self._lock:
+      self._update(skeleton, leaves, digests)
+      return self._delta(known)
+
+  def _update(self, skeleton, leaves, digests):
+    """Records `leaves` as the latest result, stamping those that changed."""
+    same_structure = self._structure is not None
+    if same_structure:
+      try:
+        nest.assert_same_structure(self._structure, skeleton)
+      except (TypeError, ValueError):
+        same_structure = False
+    version = self._version + 1
+    if not same_structure:
+      self._structure = skeleton
+      self._structure_version = version
+      self._leaf_versions = [version] * len(leaves)
+      changed = True
+    else:
+      changed = False
+      for i, digest in enumerate(digests):
+        if digest is None or digest != self._digests[i]:
+          self._leaf_versions[i] = version
+          changed = True
+    if changed:
+      self._version = version
+    self._leaves = leaves
+    self._digests = digests
+
+  def _delta(self, known: Tuple[int, int]) -> Dict[str, Any]:
+    epoch, since = known
+    if epoch != self._epoch or since > self._version:
+      since = 0
+    return {
+        'epoch': self._epoch,
+        'version': self._version,
+        'structure': (self._structure
+                      if self._structure_version > since else None),
+        'leaves': {
+            i: leaf for i, (leaf, leaf_version) in enumerate(
+                zip(self._leaves, self._leaf_versions)) if leaf_version > since
+        },
+    }
+
+
+class VersionedPull:
+  """Calls a versioned method, transferring only what changed.
+
+  Keeps the latest result and merges the leaves returned by every call into
+  it. The leaves of the returned nests are shared between calls and must not
+  be modified in place. Thread-safe.
+  """
+
+  def __init__(self, client, method: str):
+    """Initiates a pull of the result of `method`.
+
+    Args:
+      client: A `courier.Client` of the server the method is bound to with
+        `versioned=True`.
+      method: Name of the method.
+    """
+    self._method = getattr(client, method)
+    self._lock = threading.Lock()
+    self._epoch = 0
+    self._version = 0
+    self._structure = None
+    self._leaves: List[Any] = []
+
+  @property
+  def version(self) -> int:
+    """Gets the version of the cached result, zero if none."""
+    return self._version
+
+  def __call__(self, *args, **kwargs):
+    """Calls the method and returns its full result.
+
+    Args:
+      *args: Arguments of the method.
+      **kwargs: Keyword arguments of the method.
+
+    Returns:
+      The result of the method, rebuilt from the cached leaves which did not
+      change.
+    """
+    with self._lock:
+      known = (self._epoch, self._version)
+    delta = self._method(*args, **{KNOWN_VERSION_KWARG: known}, **kwargs)
+    with self._lock:
+      if delta['epoch'] == self._epoch and delta['version'] <= self._version:
+        # A concurrent pull already merged this version or a newer one.
+        return nest.unflatten_as(self._structure, self._leaves)
+      if delta['epoch'] != self._epoch or delta['structure'] is not None:
+        self._structure = delta['structure']
+        self._leaves = [None] * len(nest.flatten(self._structure))
+      for i, leaf in delta['leaves'].items():
+        self._leaves[i] = leaf
+      self._epoch = delta['epoch']
+      self._version = delta['version']
+      return nest.unflatten_as(self._structure, self._leaves)
@@ -0,0 +1,121 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/response_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
+#include "courier/serialization/call_key.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+void ResponseCache::Enable(absl::string_view method, absl::Duration ttl,
+                           int64_t max_entries) {
+  absl::MutexLock lock(&mu_);
+  auto inserted = methods_.try_emplace(method);
+  if (inserted.second) num_methods_.fetch_add(1, std::memory_order_relaxed);
+  Method& cached = inserted.first->second;
+  cached.ttl = ttl;
+  cached.max_entries = max_entries;
+  cached.generation = next_generation_++;
+  cached.lru.clear();
+  cached.entries.clear();
+}
+
+void ResponseCache::Disable(absl::string_view method) {
+  absl::MutexLock lock(&mu_);
+  if (methods_.erase(method) > 0) {
+    num_methods_.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+void ResponseCache::Invalidate(absl::string_view method) {
+  absl::MutexLock lock(&mu_);
+  for (auto& item : methods_) {
+    if (!method.empty() && item.first != method) continue;
+    item.second.generation = next_generation_++;
+    item.second.lru.clear();
+    item.second.entries.clear();
+  }
+}
+
+std::shared_ptr<const CallResult> ResponseCache::Lookup(
+    absl::string_view method, const CallArguments& arguments, Ticket* ticket,
+    bool* cacheable) {
+  *cacheable = false;
+  if (num_methods_.load(std::memory_order_relaxed) == 0) return nullptr;
+  {
+    absl::MutexLock lock(&mu_);
+    if (!methods_.contains(method)) return nullptr;
+  }
+  // Hashes the arguments, only for cached methods and outside of the lock.
+  absl::optional<std::string> key = CallKey(method, arguments);
+  if (!key.has_value()) return nullptr;
+  absl::MutexLock lock(&mu_);
+  auto method_it = methods_.find(method);
+  // The method may have been disabled meanwhile.
+  if (method_it == methods_.end()) return nullptr;
+  Method& cached = method_it->second;
+  auto it = cached.entries.find(*key);
+  if (it != cached.entries.end()) {
+    if (absl::Now() < it->second.expiration) {
+      cached.lru.splice(cached.lru.begin(), cached.lru, it->second.position);
+      return it->second.result;
+    }
+    cached.lru.erase(it->second.position);
+    cached.entries.erase(it);
+  }
+  *cacheable = true;
+  ticket->method = std::string(method);
+  ticket->key = *std::move(key);
+  ticket->generation = cached.generation;
+  return nullptr;
+}
+
+void ResponseCache::Insert(const Ticket& ticket, const CallResult& result) {
+  auto shared_result = std::make_shared<const CallResult>(result);
+  absl::MutexLock lock(&mu_);
+  auto method_it = methods_.find(ticket.method);
+  if (method_it == methods_.end()) return;
+  Method& cached = method_it->second;
+  if (cached.generation != ticket.generation || cached.max_entries <= 0) {
+    return;
+  }
+  const absl::Time expiration = absl::Now() + cached.ttl;
+  auto it = cached.entries.find(ticket.key);
+  if (it != cached.entries.end()) {
+    cached.lru.splice(cached.lru.begin(), cached.lru, it->second.position);
+    it->second.result = std::move(shared_result);
+    it->second.expiration = expiration;
+    return;
+  }
+  while (cached.entries.size() >= cached.max_entries) {
+    cached.entries.erase(cached.lru.back());
+    cached.lru.pop_back();
+  }
+  cached.lru.push_front(ticket.key);
+  cached.entries[ticket.key] =
+      Entry{cached.lru.begin(), std::move(shared_result), expiration};
+}
+
+}  // namespace courier
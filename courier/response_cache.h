@@ -0,0 +1,102 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_RESPONSE_CACHE_H_
+#define COURIER_RESPONSE_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+// Results of calls of idempotent methods, keyed by method name and
+// arguments, which the server returns without calling the method handler
+// again. Only methods enabled explicitly are cached, and only calls with
+// arguments of at most `kMaxKeyedArgumentsSize` bytes. Thread-safe.
+class ResponseCache {
+ public:
+  // A call of a cached method which was not found in the cache, see
+  // `Lookup` and `Insert`.
+  struct Ticket {
+    std::string method;
+    std::string key;
+    int64_t generation = 0;
+  };
+
+  // Caches the results of `method` for `ttl`, keeping those of at most
+  // `max_entries` distinct arguments. Drops the results cached before.
+  void Enable(absl::string_view method,
+              absl::Duration ttl = absl::InfiniteDuration(),
+              int64_t max_entries = 1024) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Stops caching the results of `method`.
+  void Disable(absl::string_view method) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Drops the cached results of `method`, of all methods if empty. Calls in
+  // flight when invalidating do not cache their results.
+  void Invalidate(absl::string_view method) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns the cached result of the call, null if there is none. In that
+  // case, if `method` is cached, sets `ticket` for `Insert` and returns true
+  // through `cacheable`.
+  std::shared_ptr<const CallResult> Lookup(absl::string_view method,
+                                           const CallArguments& arguments,
+                                           Ticket* ticket, bool* cacheable)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Caches the result of the call of `ticket`, unless its method was
+  // invalidated or disabled since the lookup.
+  void Insert(const Ticket& ticket, const CallResult& result)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    std::list<std::string>::iterator position;
+    std::shared_ptr<const CallResult> result;
+    absl::Time expiration;
+  };
+
+  struct Method {
+    absl::Duration ttl;
+    int64_t max_entries;
+    // Changed by every invalidation.
+    int64_t generation = 0;
+    // Keys of the entries, the most recently used first.
+    std::list<std::string> lru;
+    absl::flat_hash_map<std::string, Entry> entries;
+  };
+
+  // Number of cached methods, lets uncached calls skip the lock.
+  std::atomic<int> num_methods_{0};
+
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::string, Method> methods_ ABSL_GUARDED_BY(mu_);
+  // Generations are unique across methods and re-enablings, so that a
+  // ticket never matches a later generation.
+  int64_t next_generation_ ABSL_GUARDED_BY(mu_) = 1;
+};
+
+}  // namespace courier
+
+#endif  // COURIER_RESPONSE_CACHE_H_
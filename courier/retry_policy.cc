@@ -0,0 +1,66 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/retry_policy.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "absl/random/random.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace courier {
+
+RetryController::RetryController(const RetryPolicy& policy)
+    : policy_(policy),
+      tokens_(policy.retry_budget_burst),
+      last_refill_(absl::Now()) {}
+
+absl::Duration RetryController::NextRetryDelay(int num_retries) {
+  absl::MutexLock lock(&mu_);
+  ++stats_.retries;
+  if (policy_.retry_budget_per_second > 0 && !TakeToken()) {
+    ++stats_.budget_exhausted;
+    return policy_.max_backoff;
+  }
+  absl::Duration backoff =
+      std::min(policy_.initial_backoff *
+                   std::pow(policy_.backoff_multiplier, num_retries),
+               policy_.max_backoff);
+  if (policy_.jitter > 0) {
+    backoff *= absl::Uniform(bitgen_, 1.0 - policy_.jitter,
+                             1.0 + policy_.jitter);
+  }
+  return backoff;
+}
+
+RetryStats RetryController::stats() const {
+  absl::MutexLock lock(&mu_);
+  return stats_;
+}
+
+bool RetryController::TakeToken() {
+  absl::Time now = absl::Now();
+  tokens_ = std::min(policy_.retry_budget_burst,
+                     tokens_ + absl::ToDoubleSeconds(now - last_refill_) *
+                                   policy_.retry_budget_per_second);
+  last_refill_ = now;
+  if (tokens_ < 1) return false;
+  tokens_ -= 1;
+  return true;
+}
+
+}  // namespace courier
@@ -0,0 +1,81 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_RETRY_POLICY_H_
+#define COURIER_RETRY_POLICY_H_
+
+#include <cstdint>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/random/random.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace courier {
+
+// How a client retries calls which failed with `Unavailable` while
+// `CallContext::wait_for_ready` is set.
+struct RetryPolicy {
+  // The n-th retry of a call waits `initial_backoff * backoff_multiplier^n`,
+  // capped at `max_backoff`.
+  absl::Duration initial_backoff = absl::Milliseconds(50);
+  absl::Duration max_backoff = absl::Seconds(5);
+  double backoff_multiplier = 1.6;
+
+  // Randomizes every backoff by up to this fraction, in both directions, so
+  // that clients which failed together do not retry together.
+  double jitter = 0.2;
+
+  // Rate, in retries per second, and burst size of the retries of all calls
+  // of a client. Retries beyond the budget wait `max_backoff`. The budget is
+  // disabled if `retry_budget_per_second` is zero.
+  double retry_budget_per_second = 10;
+  double retry_budget_burst = 100;
+};
+
+struct RetryStats {
+  // Number of retries.
+  int64_t retries = 0;
+  // Number of retries which exceeded the retry budget.
+  int64_t budget_exhausted = 0;
+};
+
+// Computes the backoffs of the retries of a client and enforces its retry
+// budget. Thread-safe.
+class RetryController {
+ public:
+  explicit RetryController(const RetryPolicy& policy);
+
+  // Records a retry and returns how long to wait before making it.
+  // `num_retries` is the number of retries the call has made so far.
+  absl::Duration NextRetryDelay(int num_retries) ABSL_LOCKS_EXCLUDED(mu_);
+
+  RetryStats stats() const ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Takes a token from the retry budget, returns false if there is none.
+  bool TakeToken() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const RetryPolicy policy_;
+
+  mutable absl::Mutex mu_;
+  absl::BitGen bitgen_ ABSL_GUARDED_BY(mu_);
+  double tokens_ ABSL_GUARDED_BY(mu_);
+  absl::Time last_refill_ ABSL_GUARDED_BY(mu_);
+  RetryStats stats_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace courier
+
+#endif  // COURIER_RETRY_POLICY_H_
@@ -0,0 +1,76 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/retry_policy.h"
+
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace courier {
+namespace {
+
+RetryPolicy PolicyWithoutRandomness() {
+  RetryPolicy policy;
+  policy.initial_backoff = absl::Milliseconds(100);
+  policy.max_backoff = absl::Seconds(1);
+  policy.backoff_multiplier = 2;
+  policy.jitter = 0;
+  policy.retry_budget_per_second = 0;
+  return policy;
+}
+
+TEST(RetryControllerTest, BackoffGrowsUpToMaximum) {
+  RetryController controller(PolicyWithoutRandomness());
+  EXPECT_EQ(controller.NextRetryDelay(0), absl::Milliseconds(100));
+  EXPECT_EQ(controller.NextRetryDelay(1), absl::Milliseconds(200));
+  EXPECT_EQ(controller.NextRetryDelay(3), absl::Milliseconds(800));
+  EXPECT_EQ(controller.NextRetryDelay(4), absl::Seconds(1));
+  EXPECT_EQ(controller.NextRetryDelay(100), absl::Seconds(1));
+  EXPECT_EQ(controller.stats().retries, 5);
+  EXPECT_EQ(controller.stats().budget_exhausted, 0);
+}
+
+TEST(RetryControllerTest, JitterStaysWithinBounds) {
+  RetryPolicy policy = PolicyWithoutRandomness();
+  policy.jitter = 0.25;
+  RetryController controller(policy);
+  absl::Duration min_delay = absl::InfiniteDuration();
+  absl::Duration max_delay = absl::ZeroDuration();
+  for (int i = 0; i < 1000; ++i) {
+    absl::Duration delay = controller.NextRetryDelay(1);
+    min_delay = std::min(min_delay, delay);
+    max_delay = std::max(max_delay, delay);
+  }
+  EXPECT_GE(min_delay, absl::Milliseconds(150));
+  EXPECT_LE(max_delay, absl::Milliseconds(250));
+  // The backoffs are actually randomized.
+  EXPECT_LT(min_delay, max_delay);
+}
+
+TEST(RetryControllerTest, ExhaustedBudgetWaitsMaximumBackoff) {
+  RetryPolicy policy = PolicyWithoutRandomness();
+  policy.retry_budget_per_second = 1e-6;
+  policy.retry_budget_burst = 2;
+  RetryController controller(policy);
+  EXPECT_EQ(controller.NextRetryDelay(0), absl::Milliseconds(100));
+  EXPECT_EQ(controller.NextRetryDelay(0), absl::Milliseconds(100));
+  EXPECT_EQ(controller.NextRetryDelay(0), absl::Seconds(1));
+  EXPECT_EQ(controller.stats().retries, 3);
+  EXPECT_EQ(controller.stats().budget_exhausted, 1);
+}
+
+}  // namespace
+}  // namespace courier
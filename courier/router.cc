@@ -42,12 +42,14 @@ absl::Status Router::Bind(absl::string_view method,
   absl::WriterMutexLock lock(&mu_);
   handlers_[std::string(method)] =
       absl::make_unique<CallCountingHandler>(std::move(method_handler));
+  response_cache_.Disable(method);
   return absl::OkStatus();
 }
 
 void Router::Unbind(absl::string_view method) {
   absl::WriterMutexLock lock(&mu_);
   handlers_.erase(std::string(method));
+  response_cache_.Disable(method);
 }
 
 absl::StatusOr<courier::CallResult> Router::Call(
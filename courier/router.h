@@ -30,6 +30,8 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "courier/handlers/interface.h"
+#include "courier/publisher.h"
+#include "courier/response_cache.h"
 #include "courier/serialization/serialization.pb.h"
 
 namespace courier {
@@ -67,6 +69,7 @@ class Router {
   //
   // If a method handler with the same name was registered before, then this
   // function blocks until concurrent calls to that handler have finished.
+  // Its results are no longer cached, see `response_cache`.
   absl::Status Bind(absl::string_view method,
                     std::shared_ptr<HandlerInterface> method_handler)
       ABSL_LOCKS_EXCLUDED(mu_);
@@ -97,6 +100,13 @@ class Router {
   // completed.
   std::vector<std::string> Names() ABSL_LOCKS_EXCLUDED(mu_);
 
+  // Values published to the subscribers of the server.
+  Publisher* publisher() { return &publisher_; }
+
+  // Results of the methods whose calls the server answers from a cache. The
+  // cache is consulted by the server, not by `Call`.
+  ResponseCache* response_cache() { return &response_cache_; }
+
  private:
   // Provides a wrapper around MethodHandler which has an internal counter
   // that tracks ongoing calls. The destructor of this class will block until
@@ -119,6 +129,9 @@ class Router {
   std::map<std::string, std::unique_ptr<CallCountingHandler>> handlers_
       ABSL_GUARDED_BY(mu_);
   absl::Mutex mu_;
+
+  Publisher publisher_;
+  ResponseCache response_cache_;
 };
 
 }  // namespace courier
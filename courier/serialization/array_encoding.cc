@@ -0,0 +1,473 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/serialization/array_encoding.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "courier/serialization/serialization.pb.h"
+#include "tensorflow/core/platform/snappy.h"
+
+namespace courier {
+namespace {
+
+uint32_t FloatBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float FloatFromBits(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Rounds to nearest even, as numpy does for `astype(np.float16)`.
+uint16_t FloatToHalf(float value) {
+  const uint32_t f = FloatBits(value);
+  const uint16_t h_sign = (f & 0x80000000u) >> 16;
+  uint32_t f_exp = f & 0x7f800000u;
+  uint32_t f_sig = f & 0x007fffffu;
+
+  // Exponent overflow and NaN convert to signed inf/NaN.
+  if (f_exp >= 0x47800000u) {
+    if (f_exp == 0x7f800000u && f_sig != 0) {
+      uint16_t nan = 0x7c00u + (f_sig >> 13);
+      // Make sure the truncated significand stays a NaN.
+      if (nan == 0x7c00u) ++nan;
+      return h_sign + nan;
+    }
+    return h_sign + 0x7c00u;
+  }
+
+  // Exponent underflow converts to a subnormal half or signed zero.
+  if (f_exp <= 0x38000000u) {
+    if (f_exp < 0x33000000u) return h_sign;
+    f_exp >>= 23;
+    f_sig += 0x00800000u;
+    f_sig >>= (113 - f_exp);
+    if ((f_sig & 0x00003fffu) != 0x00001000u || (f & 0x000007ffu)) {
+      f_sig += 0x00001000u;
+    }
+    // A carry into the exponent yields the smallest normal, as it should.
+    return h_sign + static_cast<uint16_t>(f_sig >> 13);
+  }
+
+  const uint16_t h_exp = (f_exp - 0x38000000u) >> 13;
+  if ((f_sig & 0x00003fffu) != 0x00001000u) {
+    f_sig += 0x00001000u;
+  }
+  // A carry into the exponent is correct, including overflow to inf.
+  return h_sign + static_cast<uint16_t>((f_sig >> 13) + h_exp);
+}
+
+float HalfToFloat(uint16_t h) {
+  const uint32_t f_sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+  uint16_t h_exp = h & 0x7c00u;
+  switch (h_exp) {
+    case 0x0000u: {
+      uint16_t h_sig = h & 0x03ffu;
+      if (h_sig == 0) return FloatFromBits(f_sign);
+      // Normalize the subnormal.
+      h_sig <<= 1;
+      while ((h_sig & 0x0400u) == 0) {
+        h_sig <<= 1;
+        ++h_exp;
+      }
+      const uint32_t f_exp = static_cast<uint32_t>(127 - 15 - h_exp) << 23;
+      const uint32_t f_sig = static_cast<uint32_t>(h_sig & 0x03ffu) << 13;
+      return FloatFromBits(f_sign + f_exp + f_sig);
+    }
+    case 0x7c00u:
+      return FloatFromBits(f_sign + 0x7f800000u +
+                           (static_cast<uint32_t>(h & 0x03ffu) << 13));
+    default:
+      return FloatFromBits(
+          f_sign + ((static_cast<uint32_t>(h & 0x7fffu) + 0x1c000u) << 13));
+  }
+}
+
+// Rounds to nearest even. NaNs are kept quiet NaNs.
+uint16_t FloatToBfloat16(float value) {
+  const uint32_t f = FloatBits(value);
+  if (std::isnan(value)) {
+    return static_cast<uint16_t>((f >> 16) | 0x0040u);
+  }
+  const uint32_t lsb = (f >> 16) & 1;
+  return static_cast<uint16_t>((f + 0x7fffu + lsb) >> 16);
+}
+
+float Bfloat16ToFloat(uint16_t b) {
+  return FloatFromBits(static_cast<uint32_t>(b) << 16);
+}
+
+template <typename T>
+void EncodeAs16Bit(const T* data, int64_t num_elements,
+                   uint16_t (*convert)(float), std::string* output) {
+  output->resize(num_elements * sizeof(uint16_t));
+  uint16_t* out = reinterpret_cast<uint16_t*>(&(*output)[0]);
+  for (int64_t i = 0; i < num_elements; ++i) {
+    out[i] = convert(static_cast<float>(data[i]));
+  }
+}
+
+template <typename T>
+void EncodeAsInt8(const T* data, int64_t num_elements, EncodedArray* encoded) {
+  double min_value = 0;
+  double max_value = 0;
+  if (num_elements > 0) {
+    auto minmax = std::minmax_element(data, data + num_elements);
+    min_value = *minmax.first;
+    max_value = *minmax.second;
+  }
+  const double scale = (max_value - min_value) / 255.0;
+  const double offset = min_value + 128.0 * scale;
+  encoded->set_scale(scale);
+  encoded->set_offset(scale == 0 ? min_value : offset);
+
+  std::string* output = encoded->mutable_data();
+  output->resize(num_elements);
+  int8_t* out = reinterpret_cast<int8_t*>(&(*output)[0]);
+  for (int64_t i = 0; i < num_elements; ++i) {
+    if (scale == 0) {
+      out[i] = 0;
+      continue;
+    }
+    const double q = std::round((data[i] - offset) / scale);
+    out[i] = static_cast<int8_t>(std::max(-128.0, std::min(127.0, q)));
+  }
+}
+
+template <typename T>
+absl::Status Encode(const T* data, int64_t num_elements,
+                    EncodedArray::Encoding encoding, EncodedArray* encoded) {
+  if (encoding == EncodedArray::INT8 &&
+      !std::all_of(data, data + num_elements,
+                   [](T value) { return std::isfinite(value); })) {
+    encoding = EncodedArray::BFLOAT16;
+  }
+  encoded->set_encoding(encoding);
+  switch (encoding) {
+    case EncodedArray::RAW:
+      encoded->set_data(reinterpret_cast<const char*>(data),
+                        num_elements * sizeof(T));
+      return absl::OkStatus();
+    case EncodedArray::FLOAT16:
+      EncodeAs16Bit(data, num_elements, &FloatToHalf, encoded->mutable_data());
+      return absl::OkStatus();
+    case EncodedArray::BFLOAT16:
+      EncodeAs16Bit(data, num_elements, &FloatToBfloat16,
+                    encoded->mutable_data());
+      return absl::OkStatus();
+    case EncodedArray::INT8:
+      EncodeAsInt8(data, num_elements, encoded);
+      return absl::OkStatus();
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported array encoding: ", encoding));
+  }
+}
+
+struct AtomicCompressionStats {
+  std::atomic<int64_t> compressed{0};
+  std::atomic<int64_t> skipped_too_small{0};
+  std::atomic<int64_t> skipped_incompressible{0};
+  std::atomic<int64_t> uncompressed_bytes{0};
+  std::atomic<int64_t> compressed_bytes{0};
+};
+
+AtomicCompressionStats& GlobalCompressionStats() {
+  static auto* stats = new AtomicCompressionStats();
+  return *stats;
+}
+
+// Groups the k-th bytes of all `element_size` sized elements together.
+void ByteShuffle(absl::string_view input, int element_size,
+                 std::string* output) {
+  const size_t num_elements = input.size() / element_size;
+  output->resize(input.size());
+  char* out = &(*output)[0];
+  for (int b = 0; b < element_size; ++b) {
+    for (size_t i = 0; i < num_elements; ++i) {
+      *out++ = input[i * element_size + b];
+    }
+  }
+}
+
+void ByteUnshuffle(absl::string_view input, int element_size,
+                   std::string* output) {
+  const size_t num_elements = input.size() / element_size;
+  output->resize(input.size());
+  char* out = &(*output)[0];
+  const char* in = input.data();
+  for (int b = 0; b < element_size; ++b) {
+    for (size_t i = 0; i < num_elements; ++i) {
+      out[i * element_size + b] = *in++;
+    }
+  }
+}
+
+absl::Status UnexpectedSize(size_t size, size_t expected_size) {
+  return absl::InvalidArgumentError(
+      absl::StrCat("Encoded array holds ", size, " bytes but ", expected_size,
+                   " were expected."));
+}
+
+// Returns the data of `encoded`, decompressing it into `storage` if needed.
+// Fails unless the data holds exactly `expected_size` bytes, which is checked
+// before allocating any buffer.
+absl::StatusOr<absl::string_view> UncompressedData(const EncodedArray& encoded,
+                                                   size_t expected_size,
+                                                   std::string* storage) {
+  const Compression& compression = encoded.compression();
+  switch (compression.codec()) {
+    case Compression::NONE:
+      if (encoded.data().size() != expected_size) {
+        return UnexpectedSize(encoded.data().size(), expected_size);
+      }
+      return absl::string_view(encoded.data());
+    case Compression::SNAPPY:
+      break;
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported compression codec: ", compression.codec()));
+  }
+
+  const std::string& data = encoded.data();
+  size_t size;
+  if (!tensorflow::port::Snappy_GetUncompressedLength(data.data(), data.size(),
+                                                      &size) ||
+      size != compression.uncompressed_size()) {
+    return absl::InvalidArgumentError("Corrupted compressed array data.");
+  }
+  // Both sizes come from the peer, only trust the one of the array.
+  if (size != expected_size) return UnexpectedSize(size, expected_size);
+  if (compression.shuffle_element_size() > 1 &&
+      size % compression.shuffle_element_size() != 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Compressed array data of ", size,
+                     " bytes is not made of elements of ",
+                     compression.shuffle_element_size(), " bytes."));
+  }
+  std::string uncompressed(size, '\0');
+  if (!tensorflow::port::Snappy_Uncompress(data.data(), data.size(),
+                                           &uncompressed[0])) {
+    return absl::InvalidArgumentError("Corrupted compressed array data.");
+  }
+  if (compression.shuffle_element_size() > 1) {
+    ByteUnshuffle(uncompressed, compression.shuffle_element_size(), storage);
+  } else {
+    *storage = std::move(uncompressed);
+  }
+  return absl::string_view(*storage);
+}
+
+template <typename T>
+absl::Status Decode(const EncodedArray& encoded, int64_t num_elements,
+                    T* output) {
+  size_t element_size;
+  switch (encoded.encoding()) {
+    case EncodedArray::RAW:
+      element_size = sizeof(T);
+      break;
+    case EncodedArray::FLOAT16:
+    case EncodedArray::BFLOAT16:
+      element_size = sizeof(uint16_t);
+      break;
+    case EncodedArray::INT8:
+      element_size = sizeof(int8_t);
+      break;
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported array encoding: ", encoded.encoding()));
+  }
+  std::string storage;
+  absl::StatusOr<absl::string_view> payload =
+      UncompressedData(encoded, num_elements * element_size, &storage);
+  if (!payload.ok()) return payload.status();
+
+  const char* data = payload->data();
+  switch (encoded.encoding()) {
+    case EncodedArray::RAW:
+      std::memcpy(output, data, payload->size());
+      break;
+    case EncodedArray::FLOAT16: {
+      const uint16_t* in = reinterpret_cast<const uint16_t*>(data);
+      for (int64_t i = 0; i < num_elements; ++i) {
+        output[i] = HalfToFloat(in[i]);
+      }
+      break;
+    }
+    case EncodedArray::BFLOAT16: {
+      const uint16_t* in = reinterpret_cast<const uint16_t*>(data);
+      for (int64_t i = 0; i < num_elements; ++i) {
+        output[i] = Bfloat16ToFloat(in[i]);
+      }
+      break;
+    }
+    case EncodedArray::INT8: {
+      const int8_t* in = reinterpret_cast<const int8_t*>(data);
+      for (int64_t i = 0; i < num_elements; ++i) {
+        output[i] = static_cast<T>(in[i] * encoded.scale() + encoded.offset());
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<EncodedArray::Encoding> ParseArrayEncoding(
+    absl::string_view name) {
+  if (name.empty()) return EncodedArray::RAW;
+  EncodedArray::Encoding encoding;
+  if (!EncodedArray::Encoding_Parse(absl::AsciiStrToUpper(name), &encoding)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unknown array encoding: ", name));
+  }
+  return encoding;
+}
+
+absl::Status EncodeFloatArray(const float* data, int64_t num_elements,
+                              EncodedArray::Encoding encoding,
+                              EncodedArray* encoded) {
+  return Encode(data, num_elements, encoding, encoded);
+}
+
+absl::Status EncodeFloatArray(const double* data, int64_t num_elements,
+                              EncodedArray::Encoding encoding,
+                              EncodedArray* encoded) {
+  return Encode(data, num_elements, encoding, encoded);
+}
+
+absl::Status DecodeFloatArray(const EncodedArray& encoded,
+                              int64_t num_elements, float* output) {
+  return Decode(encoded, num_elements, output);
+}
+
+absl::Status DecodeFloatArray(const EncodedArray& encoded,
+                              int64_t num_elements, double* output) {
+  return Decode(encoded, num_elements, output);
+}
+
+absl::Status DecodeRawArray(const EncodedArray& encoded, int64_t num_bytes,
+                            void* output) {
+  if (encoded.encoding() != EncodedArray::RAW) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Array encoding ", encoded.encoding(), " is not supported for dtype ",
+        encoded.dtype()));
+  }
+  if (num_bytes < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid size of an array: ", num_bytes));
+  }
+  std::string storage;
+  absl::StatusOr<absl::string_view> payload =
+      UncompressedData(encoded, num_bytes, &storage);
+  if (!payload.ok()) return payload.status();
+  std::memcpy(output, payload->data(), payload->size());
+  return absl::OkStatus();
+}
+
+absl::StatusOr<Compression::Codec> ParseCompressionCodec(
+    absl::string_view name) {
+  if (name.empty()) return Compression::NONE;
+  Compression::Codec codec;
+  if (!Compression::Codec_Parse(absl::AsciiStrToUpper(name), &codec)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unknown compression codec: ", name));
+  }
+  return codec;
+}
+
+absl::Status CompressArrayData(const CompressionOptions& options,
+                               int element_size, EncodedArray* encoded) {
+  switch (options.codec) {
+    case Compression::NONE:
+      return absl::OkStatus();
+    case Compression::SNAPPY:
+      break;
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unsupported compression codec: ", options.codec));
+  }
+  AtomicCompressionStats& stats = GlobalCompressionStats();
+  const std::string& data = encoded->data();
+  if (static_cast<int64_t>(data.size()) < options.min_size_bytes) {
+    stats.skipped_too_small.fetch_add(1, std::memory_order_relaxed);
+    return absl::OkStatus();
+  }
+
+  std::string shuffled;
+  absl::string_view input = data;
+  const bool shuffle = options.byte_shuffle && element_size > 1 &&
+                       data.size() % element_size == 0;
+  if (shuffle) {
+    ByteShuffle(data, element_size, &shuffled);
+    input = shuffled;
+  }
+  std::string compressed;
+  if (!tensorflow::port::Snappy_Compress(input.data(), input.size(),
+                                         &compressed)) {
+    return absl::UnimplementedError(
+        "Snappy compression is not available in this build.");
+  }
+  if (compressed.size() > options.max_ratio * input.size()) {
+    stats.skipped_incompressible.fetch_add(1, std::memory_order_relaxed);
+    return absl::OkStatus();
+  }
+
+  stats.compressed.fetch_add(1, std::memory_order_relaxed);
+  stats.uncompressed_bytes.fetch_add(input.size(), std::memory_order_relaxed);
+  stats.compressed_bytes.fetch_add(compressed.size(),
+                                   std::memory_order_relaxed);
+  Compression* compression = encoded->mutable_compression();
+  compression->set_codec(options.codec);
+  compression->set_shuffle_element_size(shuffle ? element_size : 0);
+  compression->set_uncompressed_size(input.size());
+  *encoded->mutable_data() = std::move(compressed);
+  return absl::OkStatus();
+}
+
+CompressionStats GetCompressionStats() {
+  const AtomicCompressionStats& stats = GlobalCompressionStats();
+  CompressionStats result;
+  result.compressed = stats.compressed.load(std::memory_order_relaxed);
+  result.skipped_too_small =
+      stats.skipped_too_small.load(std::memory_order_relaxed);
+  result.skipped_incompressible =
+      stats.skipped_incompressible.load(std::memory_order_relaxed);
+  result.uncompressed_bytes =
+      stats.uncompressed_bytes.load(std::memory_order_relaxed);
+  result.compressed_bytes =
+      stats.compressed_bytes.load(std::memory_order_relaxed);
+  return result;
+}
+
+}  // namespace courier
@@ -0,0 +1,102 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_SERIALIZATION_ARRAY_ENCODING_H_
+#define COURIER_SERIALIZATION_ARRAY_ENCODING_H_
+
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+// Parses the name of an `EncodedArray::Encoding` (case insensitive). An empty
+// name is parsed as `RAW`.
+absl::StatusOr<EncodedArray::Encoding> ParseArrayEncoding(
+    absl::string_view name);
+
+// Encodes `num_elements` values from `data` into `encoded->data()` using
+// `encoding`. The caller is responsible for setting `dtype` and `shape`.
+//
+// INT8 quantization requires all values to be finite. Arrays containing
+// non-finite values are encoded as BFLOAT16 instead, which preserves the
+// float32 exponent range.
+absl::Status EncodeFloatArray(const float* data, int64_t num_elements,
+                              EncodedArray::Encoding encoding,
+                              EncodedArray* encoded);
+absl::Status EncodeFloatArray(const double* data, int64_t num_elements,
+                              EncodedArray::Encoding encoding,
+                              EncodedArray* encoded);
+
+// Decodes `num_elements` values from `encoded` into `output`, up-casting
+// them if `encoded` holds a lossy encoding.
+absl::Status DecodeFloatArray(const EncodedArray& encoded,
+                              int64_t num_elements, float* output);
+absl::Status DecodeFloatArray(const EncodedArray& encoded,
+                              int64_t num_elements, double* output);
+
+// Copies the content of a RAW `encoded` array of any dtype into `output`,
+// which must hold exactly `num_bytes`.
+absl::Status DecodeRawArray(const EncodedArray& encoded, int64_t num_bytes,
+                            void* output);
+
+// Parses the name of a `Compression::Codec` (case insensitive). An empty name
+// is parsed as `NONE`.
+absl::StatusOr<Compression::Codec> ParseCompressionCodec(
+    absl::string_view name);
+
+// Controls when and how the data of encoded arrays is compressed.
+struct CompressionOptions {
+  Compression::Codec codec = Compression::NONE;
+
+  // Whether to byte-shuffle multi-byte elements before compressing them.
+  bool byte_shuffle = true;
+
+  // Payloads smaller than this are sent as is, the compression overhead is
+  // not worth it.
+  int64_t min_size_bytes = 16 << 10;
+
+  // The compressed payload is only kept if it is at most this fraction of
+  // the uncompressed size. Incompressible data (e.g. noise or already
+  // compressed images) is therefore sent as is.
+  double max_ratio = 0.9;
+};
+
+// Compresses `encoded->data()` in place according to `options`. `element_size`
+// is the size in bytes of a single encoded element and is used by the
+// byte-shuffle filter. The data is left untouched if compression is skipped.
+absl::Status CompressArrayData(const CompressionOptions& options,
+                               int element_size, EncodedArray* encoded);
+
+// Counters describing the effect of `CompressArrayData` in this process.
+struct CompressionStats {
+  // Number of payloads sent compressed.
+  int64_t compressed = 0;
+  // Number of payloads sent as is because they were too small.
+  int64_t skipped_too_small = 0;
+  // Number of payloads sent as is because they did not compress well.
+  int64_t skipped_incompressible = 0;
+  // Total size of the compressed payloads before and after compression.
+  int64_t uncompressed_bytes = 0;
+  int64_t compressed_bytes = 0;
+};
+
+CompressionStats GetCompressionStats();
+
+}  // namespace courier
+
+#endif  // COURIER_SERIALIZATION_ARRAY_ENCODING_H_
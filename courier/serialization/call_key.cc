@@ -0,0 +1,46 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "courier/serialization/call_key.h"
+
+#include <cstdint>
+#include <string>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "openssl/sha.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+absl::optional<std::string> CallKey(absl::string_view method,
+                                    const CallArguments& arguments) {
+  if (arguments.ByteSizeLong() > kMaxKeyedArgumentsSize) return absl::nullopt;
+  std::string serialized(method);
+  serialized.push_back('\0');
+  {
+    google::protobuf::io::StringOutputStream output(&serialized);
+    google::protobuf::io::CodedOutputStream coded_output(&output);
+    coded_output.SetSerializationDeterministic(true);
+    arguments.SerializeToCodedStream(&coded_output);
+  }
+  std::string key(SHA256_DIGEST_LENGTH, '\0');
+  SHA256(reinterpret_cast<const uint8_t*>(serialized.data()),
+         serialized.size(), reinterpret_cast<uint8_t*>(&key[0]));
+  return key;
+}
+
+}  // namespace courier
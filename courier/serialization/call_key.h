@@ -0,0 +1,41 @@
+// Copyright 2020 DeepMind Technologies Limited.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COURIER_SERIALIZATION_CALL_KEY_H_
+#define COURIER_SERIALIZATION_CALL_KEY_H_
+
+#include <cstddef>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "courier/serialization/serialization.pb.h"
+
+namespace courier {
+
+// Calls with larger serialized arguments have no key: building it would cost
+// more than looking the call up is likely to save.
+constexpr size_t kMaxKeyedArgumentsSize = 1 << 16;
+
+// Returns a key identifying a call of `method` with `arguments`, equal for
+// calls with equal arguments regardless of the order of their keyword
+// arguments: the SHA-256 digest of the method name and of the deterministic
+// serialization of the arguments. Returns nullopt if the arguments exceed
+// `kMaxKeyedArgumentsSize`.
+absl::optional<std::string> CallKey(absl::string_view method,
+                                    const CallArguments& arguments);
+
+}  // namespace courier
+
+#endif  // COURIER_SERIALIZATION_CALL_KEY_H_
@@ -16,9 +16,12 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "courier/platform/default/py_utils.h"
 #include "absl/container/flat_hash_map.h"
@@ -31,6 +34,7 @@
 #include "absl/synchronization/mutex.h"
 #include "courier/platform/status_macros.h"
 #include "courier/platform/tensor_conversion.h"
+#include "courier/serialization/array_encoding.h"
 #include "courier/serialization/serialization.pb.h"
 #include "tensorflow/python/lib/core/bfloat16.h"
 #include "tensorflow/python/lib/core/ndarray_tensor.h"
@@ -386,10 +390,362 @@ absl::StatusOr<PyArrayObject*> DeserializeByteArray(PyArrayObject* array) {
   return unicode_array.release();
 }
 
+// Type of `mmap.mmap`, looked up on first use. Guarded by the GIL.
+PyTypeObject* mmap_type = nullptr;
+
+bool IsMmap(PyObject* object) {
+  if (mmap_type == nullptr) {
+    // `ImportClass` keeps a reference to the class for the process lifetime.
+    absl::StatusOr<PyObject*> mmap_class = ImportClass("mmap", "mmap");
+    if (!mmap_class.ok() || !PyType_Check(*mmap_class)) return false;
+    mmap_type = reinterpret_cast<PyTypeObject*>(*mmap_class);
+  }
+  return PyObject_TypeCheck(object, mmap_type);
+}
+
+// Copies the content of a bytearray, memoryview or mmap directly into
+// `buffer->string_value()`. Multi-dimensional or non-contiguous memoryviews
+// are flattened in C order.
+absl::Status SerializeBytesLike(PyObject* object, SerializedObject* buffer) {
+  Py_buffer view;
+  if (PyObject_GetBuffer(object, &view, PyBUF_FULL_RO) != 0) {
+    PyErr_Clear();
+    return absl::InvalidArgumentError("Failed to access the object's buffer.");
+  }
+  if (PyBuffer_IsContiguous(&view, 'C')) {
+    buffer->set_string_value(static_cast<const char*>(view.buf), view.len);
+  } else {
+    std::string* data = buffer->mutable_string_value();
+    data->resize(view.len);
+    if (PyBuffer_ToContiguous(&(*data)[0], &view, view.len, 'C') != 0) {
+      PyErr_Clear();
+      PyBuffer_Release(&view);
+      return absl::InvalidArgumentError("Failed to copy the object's buffer.");
+    }
+  }
+  PyBuffer_Release(&view);
+  buffer->set_buffer_type(PyByteArray_Check(object)
+                              ? SerializedObject::BYTEARRAY
+                              : SerializedObject::MEMORYVIEW);
+  return absl::OkStatus();
+}
+
+// Python object exposing a read-only byte range of a message which is kept
+// alive by `owner`. Used to back zero-copy memoryviews.
+struct MessageBufferObject {
+  PyObject_HEAD
+  std::shared_ptr<const void>* owner;
+  const char* data;
+  Py_ssize_t size;
+};
+
+int MessageBufferGetBuffer(PyObject* self, Py_buffer* view, int flags) {
+  auto* buffer = reinterpret_cast<MessageBufferObject*>(self);
+  return PyBuffer_FillInfo(view, self, const_cast<char*>(buffer->data),
+                           buffer->size, /*readonly=*/1, flags);
+}
+
+void MessageBufferDealloc(PyObject* self) {
+  auto* buffer = reinterpret_cast<MessageBufferObject*>(self);
+  delete buffer->owner;
+  PyTypeObject* type = Py_TYPE(self);
+  type->tp_free(self);
+  Py_DECREF(type);
+}
+
+PyTypeObject* MessageBufferType() {
+  static PyTypeObject* type = [] {
+    static PyType_Slot slots[] = {
+        {Py_bf_getbuffer, reinterpret_cast<void*>(&MessageBufferGetBuffer)},
+        {Py_tp_dealloc, reinterpret_cast<void*>(&MessageBufferDealloc)},
+        {0, nullptr},
+    };
+    static PyType_Spec spec = {
+        "courier.MessageBuffer", sizeof(MessageBufferObject), 0,
+        Py_TPFLAGS_DEFAULT, slots};
+    return reinterpret_cast<PyTypeObject*>(PyType_FromSpec(&spec));
+  }();
+  return type;
+}
+
+absl::StatusOr<PyObject*> MessageMemoryView(
+    const std::string& data, const std::shared_ptr<const void>& owner) {
+  PyTypeObject* type = MessageBufferType();
+  COURIER_RET_CHECK(type != nullptr);
+  MessageBufferObject* buffer = PyObject_New(MessageBufferObject, type);
+  COURIER_RET_CHECK(buffer != nullptr);
+  buffer->owner = new std::shared_ptr<const void>(owner);
+  buffer->data = data.data();
+  buffer->size = data.size();
+  SafePyObjectPtr holder(reinterpret_cast<PyObject*>(buffer));
+  PyObject* view = PyMemoryView_FromObject(holder.get());
+  COURIER_RET_CHECK(view != nullptr);
+  return view;
+}
+
+// Python object holding a value serialized once, see `SerializedValueType`.
+struct SerializedValueObject {
+  PyObject_HEAD
+  std::shared_ptr<const SerializedObject>* value;
+};
+
+// Name of the type, a cheap first test of whether an object is an instance.
+constexpr char kSerializedValueTypeName[] = "courier.Serialized";
+
+// Module creating the type, see `SerializedValueType`, and the attribute
+// holding the capsule through which it shares the type.
+constexpr char kSerializedValueTypeModule[] = "courier.python.py_client";
+constexpr char kSerializedValueTypeAttribute[] = "_serialized_value_type";
+constexpr char kSerializedValueTypeCapsule[] =
+    "courier.python.py_client._serialized_value_type";
+
+PyObject* SerializedValueNew(PyTypeObject* type, PyObject* args,
+                             PyObject* kwargs) {
+  static const char* keywords[] = {"value", nullptr};
+  PyObject* value;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:Serialized",
+                                   const_cast<char**>(keywords), &value)) {
+    return nullptr;
+  }
+  auto serialized = std::make_shared<SerializedObject>();
+  absl::Status status = SerializePyObject(value, serialized.get());
+  if (!status.ok()) {
+    PyErr_SetString(PyExc_ValueError, std::string(status.message()).c_str());
+    return nullptr;
+  }
+  auto* self =
+      reinterpret_cast<SerializedValueObject*>(type->tp_alloc(type, 0));
+  if (self == nullptr) return nullptr;
+  self->value =
+      new std::shared_ptr<const SerializedObject>(std::move(serialized));
+  return reinterpret_cast<PyObject*>(self);
+}
+
+void SerializedValueDealloc(PyObject* self) {
+  delete reinterpret_cast<SerializedValueObject*>(self)->value;
+  PyTypeObject* type = Py_TYPE(self);
+  type->tp_free(self);
+  Py_DECREF(type);
+}
+
+PyObject* SerializedValueGetSize(PyObject* self, void*) {
+  return PyLong_FromSize_t(
+      (*reinterpret_cast<SerializedValueObject*>(self)->value)
+          ->ByteSizeLong());
+}
+
+// Returns the type shared by the module creating it, or null while that
+// module has not been imported, in which case there are no instances yet.
+PyTypeObject* SharedSerializedValueType() {
+  // Guarded by the GIL. Never reset, the module owns the type for good.
+  static PyTypeObject* shared_type = nullptr;
+  if (shared_type != nullptr) return shared_type;
+  SafePyObjectPtr name(PyUnicode_FromString(kSerializedValueTypeModule));
+  if (name == nullptr) {
+    PyErr_Clear();
+    return nullptr;
+  }
+  SafePyObjectPtr module(PyImport_GetModule(name.get()));
+  if (module == nullptr) {
+    PyErr_Clear();
+    return nullptr;
+  }
+  SafePyObjectPtr capsule(
+      PyObject_GetAttrString(module.get(), kSerializedValueTypeAttribute));
+  if (capsule == nullptr) {
+    PyErr_Clear();
+    return nullptr;
+  }
+  shared_type = static_cast<PyTypeObject*>(
+      PyCapsule_GetPointer(capsule.get(), kSerializedValueTypeCapsule));
+  if (shared_type == nullptr) PyErr_Clear();
+  return shared_type;
+}
+
+bool IsSerializedValue(PyObject* object) {
+  if (std::strcmp(Py_TYPE(object)->tp_name, kSerializedValueTypeName) != 0) {
+    return false;
+  }
+  PyTypeObject* type = SharedSerializedValueType();
+  return type != nullptr && PyObject_TypeCheck(object, type);
+}
+
+absl::StatusOr<PyObject*> DeserializeBytes(
+    const SerializedObject& buffer, const DeserializationOptions& options) {
+  const std::string& data = buffer.string_value();
+  PyObject* result;
+  if (buffer.buffer_type() == SerializedObject::BYTEARRAY) {
+    result = PyByteArray_FromStringAndSize(data.data(), data.size());
+  } else if (options.bytes_as_memoryview) {
+    COURIER_RET_CHECK(options.message_owner != nullptr);
+    return MessageMemoryView(data, options.message_owner);
+  } else if (buffer.buffer_type() == SerializedObject::MEMORYVIEW) {
+    SafePyObjectPtr bytes(
+        PyBytes_FromStringAndSize(data.data(), data.size()));
+    COURIER_RET_CHECK(bytes != nullptr);
+    result = PyMemoryView_FromObject(bytes.get());
+  } else {
+    result = PyBytes_FromStringAndSize(data.data(), data.size());
+  }
+  COURIER_RET_CHECK(result)
+      << "Failed to build python string from proto string.";
+  return result;
+}
+
+// Returns true if `object` is a numpy array which `options` ask to be packed
+// as an `EncodedArray` rather than via __reduce__.
+bool ShouldEncodeArray(PyObject* object, const SerializationOptions& options) {
+  if (!PyArray_CheckExact(object)) return false;
+  PyArrayObject* array = reinterpret_cast<PyArrayObject*>(object);
+  if (!PyArray_ISNOTSWAPPED(array)) return false;
+  int array_type = PyArray_TYPE(array);
+  if (options.float_encoding != EncodedArray::RAW &&
+      (array_type == NPY_FLOAT32 || array_type == NPY_FLOAT64)) {
+    return true;
+  }
+  return options.compression.codec != Compression::NONE &&
+         (PyArray_ISNUMBER(array) || PyArray_ISBOOL(array));
+}
+
+absl::Status SerializeEncodedArray(PyArrayObject* array,
+                                   const SerializationOptions& options,
+                                   EncodedArray* encoded) {
+  SafePyObjectPtr dtype_str(PyObject_GetAttrString(
+      reinterpret_cast<PyObject*>(PyArray_DESCR(array)), "str"));
+  COURIER_RET_CHECK(dtype_str != nullptr);
+  COURIER_RET_CHECK(PythonUtils::CPPString_FromPyString(
+      dtype_str.get(), encoded->mutable_dtype()));
+  encoded->mutable_shape()->Reserve(PyArray_NDIM(array));
+  for (int i = 0; i < PyArray_NDIM(array); ++i) {
+    encoded->add_shape(PyArray_DIM(array, i));
+  }
+
+  // The encoders read the array as a flat buffer.
+  auto contiguous = MakeSafePyPtr<PyArrayObject>(
+      reinterpret_cast<PyObject*>(PyArray_GETCONTIGUOUS(array)));
+  COURIER_RET_CHECK(contiguous != nullptr);
+  const void* data = PyArray_DATA(contiguous.get());
+  int64_t size = PyArray_SIZE(contiguous.get());
+  switch (PyArray_TYPE(array)) {
+    case NPY_FLOAT32:
+      COURIER_RETURN_IF_ERROR(
+          EncodeFloatArray(static_cast<const float*>(data), size,
+                           options.float_encoding, encoded));
+      break;
+    case NPY_FLOAT64:
+      COURIER_RETURN_IF_ERROR(
+          EncodeFloatArray(static_cast<const double*>(data), size,
+                           options.float_encoding, encoded));
+      break;
+    default:
+      encoded->set_encoding(EncodedArray::RAW);
+      encoded->set_data(static_cast<const char*>(data),
+                        PyArray_NBYTES(contiguous.get()));
+  }
+
+  int element_size;
+  switch (encoded->encoding()) {
+    case EncodedArray::FLOAT16:
+    case EncodedArray::BFLOAT16:
+      element_size = 2;
+      break;
+    case EncodedArray::INT8:
+      element_size = 1;
+      break;
+    default:
+      element_size = PyArray_ITEMSIZE(array);
+  }
+  return CompressArrayData(options.compression, element_size, encoded);
+}
+
+// Allocates a numpy array of the original dtype and up-casts the (possibly
+// lossy) encoded values into it.
+absl::StatusOr<PyObject*> DeserializeEncodedArray(
+    const EncodedArray& encoded) {
+  SafePyObjectPtr dtype_str(PyUnicode_FromStringAndSize(
+      encoded.dtype().data(), encoded.dtype().size()));
+  COURIER_RET_CHECK(dtype_str != nullptr);
+  PyArray_Descr* descr = nullptr;
+  if (!PyArray_DescrConverter(dtype_str.get(), &descr)) {
+    PyErr_Clear();
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid numpy dtype: ", encoded.dtype()));
+  }
+  // The content is copied verbatim, which is only safe for plain numeric
+  // dtypes: object dtypes would hold pointers taken from the message.
+  if (!PyDataType_ISBOOL(descr) && !PyDataType_ISINTEGER(descr) &&
+      !PyDataType_ISFLOAT(descr) && !PyDataType_ISCOMPLEX(descr)) {
+    Py_DECREF(descr);
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Unsupported dtype for an encoded array: ", encoded.dtype()));
+  }
+
+  // PyArray_NewFromDescr steals the reference to `descr`.
+  std::vector<npy_intp> dims(encoded.shape().begin(), encoded.shape().end());
+  auto result = MakeSafePyPtr<PyArrayObject>(
+      PyArray_NewFromDescr(&PyArray_Type, descr, dims.size(), dims.data(),
+                           /*strides=*/nullptr, /*data=*/nullptr,
+                           /*flags=*/0, /*obj=*/nullptr));
+  COURIER_RET_CHECK(result != nullptr);
+
+  void* data = PyArray_DATA(result.get());
+  int64_t size = PyArray_SIZE(result.get());
+  // The decoders fail unless the message holds exactly the expected number
+  // of bytes.
+  switch (PyArray_TYPE(result.get())) {
+    case NPY_FLOAT32:
+      COURIER_RET_CHECK_EQ(size * int64_t{sizeof(float)},
+                           PyArray_NBYTES(result.get()));
+      COURIER_RETURN_IF_ERROR(
+          DecodeFloatArray(encoded, size, static_cast<float*>(data)));
+      break;
+    case NPY_FLOAT64:
+      COURIER_RET_CHECK_EQ(size * int64_t{sizeof(double)},
+                           PyArray_NBYTES(result.get()));
+      COURIER_RETURN_IF_ERROR(
+          DecodeFloatArray(encoded, size, static_cast<double*>(data)));
+      break;
+    default:
+      COURIER_RETURN_IF_ERROR(
+          DecodeRawArray(encoded, PyArray_NBYTES(result.get()), data));
+  }
+  return reinterpret_cast<PyObject*>(result.release());
+}
+
 
 }  // namespace
 
-absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer) {
+PyTypeObject* SerializedValueType() {
+  static PyTypeObject* type = [] {
+    static PyGetSetDef getset[] = {
+        {const_cast<char*>("size"), &SerializedValueGetSize, nullptr,
+         const_cast<char*>("Size of the serialized value in bytes."), nullptr},
+        {nullptr},
+    };
+    static PyType_Slot slots[] = {
+        {Py_tp_new, reinterpret_cast<void*>(&SerializedValueNew)},
+        {Py_tp_dealloc, reinterpret_cast<void*>(&SerializedValueDealloc)},
+        {Py_tp_getset, getset},
+        {Py_tp_doc,
+         const_cast<char*>("Serialized(value)\n\nA value serialized once, "
+                           "copied wherever it is sent.")},
+        {0, nullptr},
+    };
+    static PyType_Spec spec = {
+        kSerializedValueTypeName, sizeof(SerializedValueObject), 0,
+        Py_TPFLAGS_DEFAULT, slots};
+    return reinterpret_cast<PyTypeObject*>(PyType_FromSpec(&spec));
+  }();
+  return type;
+}
+
+PyObject* NewSerializedValueTypeCapsule() {
+  return PyCapsule_New(SerializedValueType(), kSerializedValueTypeCapsule,
+                       nullptr);
+}
+
+absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer,
+                               const SerializationOptions& options) {
   CHECK(Py_IsInitialized()) << "The Python interpreter has not been "
                                "initialized using Py_Initialize()";
   if (PyBool_Check(object)) {
@@ -405,33 +761,33 @@ absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer) {
     }
     buffer->set_double_value(PyFloat_AsDouble(object));
   } else if (PyBytes_Check(object)) {
-    std::string result;
-    if (!PythonUtils::CPPString_FromPyString(object, &result)) {
-      return absl::InternalError("Failed to serialize bytes string.");
-    }
-    buffer->set_string_value(std::move(result));
+    // Copied straight into the message, without a temporary std::string.
+    buffer->set_string_value(PyBytes_AS_STRING(object),
+                             PyBytes_GET_SIZE(object));
   } else if (PyUnicode_Check(object)) {
-    std::string result;
-    if (!PythonUtils::CPPString_FromPyString(object, &result)) {
+    Py_ssize_t size;
+    const char* data = PyUnicode_AsUTF8AndSize(object, &size);
+    if (data == nullptr) {
+      PyErr_Clear();
       return absl::InternalError("Failed to serialize unicode string.");
     }
-    buffer->set_unicode_value(std::move(result));
+    buffer->set_unicode_value(data, size);
   } else if (object == Py_None) {
     buffer->set_none_value(true);
   } else if (PyList_CheckExact(object)) {
     SerializedList* list = buffer->mutable_list_value();
     Py_ssize_t size = PyList_Size(object);
     for (Py_ssize_t i = 0; i < size; ++i) {
-      COURIER_RETURN_IF_ERROR(
-          SerializePyObject(PyList_GetItem(object, i), list->add_items()));
+      COURIER_RETURN_IF_ERROR(SerializePyObject(PyList_GetItem(object, i),
+                                                list->add_items(), options));
     }
   } else if (PyTuple_CheckExact(object)) {
     SerializedList* list = buffer->mutable_list_value();
     list->set_is_tuple(true);
     Py_ssize_t size = PyTuple_Size(object);
     for (Py_ssize_t i = 0; i < size; ++i) {
-      COURIER_RETURN_IF_ERROR(
-          SerializePyObject(PyTuple_GetItem(object, i), list->add_items()));
+      COURIER_RETURN_IF_ERROR(SerializePyObject(PyTuple_GetItem(object, i),
+                                                list->add_items(), options));
     }
   } else if (PyDict_CheckExact(object)) {
     PyObject* key;
@@ -439,14 +795,26 @@ absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer) {
     Py_ssize_t position = 0;
     SerializedDict* dict = buffer->mutable_dict_value();
     while (PyDict_Next(object, &position, &key, &value)) {
-      COURIER_RETURN_IF_ERROR(SerializePyObject(key, dict->add_keys()));
-      COURIER_RETURN_IF_ERROR(SerializePyObject(value, dict->add_values()));
+      COURIER_RETURN_IF_ERROR(
+          SerializePyObject(key, dict->add_keys(), options));
+      COURIER_RETURN_IF_ERROR(
+          SerializePyObject(value, dict->add_values(), options));
     }
+  } else if (IsSerializedValue(object)) {
+    buffer->CopyFrom(
+        **reinterpret_cast<SerializedValueObject*>(object)->value);
+  } else if (ShouldEncodeArray(object, options)) {
+    COURIER_RETURN_IF_ERROR(
+        SerializeEncodedArray(reinterpret_cast<PyArrayObject*>(object),
+                              options, buffer->mutable_array_value()));
   } else if (PyType_Check(object) || PyFunction_Check(object) ||
              PyCFunction_Check(object)) {
     COURIER_RETURN_IF_ERROR(PyClassModuleAndName(
         object, buffer->mutable_type_value()->mutable_module(),
         buffer->mutable_type_value()->mutable_name()));
+  } else if (PyByteArray_Check(object) || PyMemoryView_Check(object) ||
+             IsMmap(object)) {
+    COURIER_RETURN_IF_ERROR(SerializeBytesLike(object, buffer));
   } else if (PyObject_HasAttrString(object, "__reduce__") ||
              PyObject_HasAttrString(object, "__reduce_ex__")) {
     SafePyObjectPtr reduced;
@@ -485,13 +853,15 @@ absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer) {
     PyObject* py_args = PyTuple_GetItem(reduced.get(), 1);  // borrowed.
     COURIER_RET_CHECK(PyTuple_CheckExact(py_args));
     COURIER_RETURN_IF_ERROR(SerializePyObject(
-        py_args, buffer->mutable_reduced_object_value()->mutable_args()));
+        py_args, buffer->mutable_reduced_object_value()->mutable_args(),
+        options));
 
     // Maybe serialize state.
     if (PyTuple_Size(reduced.get()) >= 3) {
       PyObject* py_state = PyTuple_GetItem(reduced.get(), 2);
       COURIER_RETURN_IF_ERROR(SerializePyObject(
-          py_state, buffer->mutable_reduced_object_value()->mutable_state()));
+          py_state, buffer->mutable_reduced_object_value()->mutable_state(),
+          options));
     }
 
     // Maybe save items contained by this object.
@@ -504,10 +874,12 @@ absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer) {
         SafePyObjectPtr item;
         while ((item = SafePyObjectPtr(PyIter_Next(iterator.get())))) {
           COURIER_RETURN_IF_ERROR(SerializePyObject(
-              item.get(), buffer->mutable_reduced_object_value()
-                              ->mutable_items()
-                              ->mutable_list_value()
-                              ->add_items()));
+              item.get(),
+              buffer->mutable_reduced_object_value()
+                  ->mutable_items()
+                  ->mutable_list_value()
+                  ->add_items(),
+              options));
         }
       }
     }
@@ -522,10 +894,12 @@ absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer) {
         SafePyObjectPtr item;
         while ((item = SafePyObjectPtr(PyIter_Next(iterator.get())))) {
           COURIER_RETURN_IF_ERROR(SerializePyObject(
-              item.get(), buffer->mutable_reduced_object_value()
-                              ->mutable_kvpairs()
-                              ->mutable_list_value()
-                              ->add_items()));
+              item.get(),
+              buffer->mutable_reduced_object_value()
+                  ->mutable_kvpairs()
+                  ->mutable_list_value()
+                  ->add_items(),
+              options));
         }
       }
     }
@@ -541,6 +915,10 @@ absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer) {
   return util::StatusFromPyException();
 }
 
+absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer) {
+  return SerializePyObject(object, buffer, SerializationOptions());
+}
+
 absl::StatusOr<SerializedObject> SerializePyObject(PyObject* object) {
   SerializedObject buffer;
   COURIER_RETURN_IF_ERROR(SerializePyObject(object, &buffer));
@@ -548,7 +926,8 @@ absl::StatusOr<SerializedObject> SerializePyObject(PyObject* object) {
 }
 
 absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
-    const SerializedObject& buffer, TensorLookup& tensor_lookup) {
+    const SerializedObject& buffer, TensorLookup& tensor_lookup,
+    const DeserializationOptions& options) {
   CHECK(Py_IsInitialized()) << "The Python interpreter has not been "
                                "initialized using Py_Initialize()";
   switch (buffer.payload_case()) {
@@ -560,13 +939,8 @@ absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
       return PyFloat_FromDouble(buffer.double_value());
     case SerializedObject::kBoolValue:
       return PyBool_FromLong(buffer.bool_value());
-    case SerializedObject::kStringValue: {
-      PyObject* py_str = PyBytes_FromStringAndSize(
-          buffer.string_value().data(), buffer.string_value().size());
-      COURIER_RET_CHECK(py_str)
-          << "Failed to build python string from proto string.";
-      return py_str;
-    }
+    case SerializedObject::kStringValue:
+      return DeserializeBytes(buffer, options);
     case SerializedObject::kUnicodeValue: {
       PyObject* py_str = PyUnicode_FromStringAndSize(
           buffer.unicode_value().data(), buffer.unicode_value().size());
@@ -583,10 +957,10 @@ absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
       for (int i = 0; i < dict.keys_size(); ++i) {
         COURIER_ASSIGN_OR_RETURN(
             SafePyObjectPtr py_key,
-            DeserializePyObject(dict.keys(i), tensor_lookup));
+            DeserializePyObject(dict.keys(i), tensor_lookup, options));
         COURIER_ASSIGN_OR_RETURN(
             SafePyObjectPtr py_value,
-            DeserializePyObject(dict.values(i), tensor_lookup));
+            DeserializePyObject(dict.values(i), tensor_lookup, options));
         PyDict_SetItem(py_dict, py_key.get(), py_value.get());
       }
       return py_dict;
@@ -598,7 +972,7 @@ absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
         for (int i = 0; i < list.items_size(); ++i) {
           COURIER_ASSIGN_OR_RETURN(
               SafePyObjectPtr py_item,
-              DeserializePyObject(list.items(i), tensor_lookup));
+              DeserializePyObject(list.items(i), tensor_lookup, options));
           PyTuple_SET_ITEM(py_tuple, i, py_item.release());
         }
         return py_tuple;
@@ -607,7 +981,7 @@ absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
         for (int i = 0; i < list.items_size(); ++i) {
           COURIER_ASSIGN_OR_RETURN(
               SafePyObjectPtr py_item,
-              DeserializePyObject(list.items(i), tensor_lookup));
+              DeserializePyObject(list.items(i), tensor_lookup, options));
           PyList_SET_ITEM(py_list, i, py_item.release());
         }
         return py_list;
@@ -627,12 +1001,15 @@ absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
           PyObject * py_class,
           ImportClass(buffer.reduced_object_value().class_module(),
                       buffer.reduced_object_value().class_name()));
+      // Reconstructors such as `array._array_reconstructor` and
+      // `ndarray.__setstate__` require bytes, not memoryviews.
+      const DeserializationOptions member_options;
 
       // Deserialize args.
       COURIER_ASSIGN_OR_RETURN(
           SafePyObjectPtr py_args,
           DeserializePyObject(buffer.reduced_object_value().args(),
-                              tensor_lookup));
+                              tensor_lookup, member_options));
 
       // Make instance.
       PyObject* py_object = PyObject_CallObject(py_class, py_args.get());
@@ -644,7 +1021,7 @@ absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
         COURIER_ASSIGN_OR_RETURN(
             SafePyObjectPtr py_state,
             DeserializePyObject(buffer.reduced_object_value().state(),
-                                tensor_lookup));
+                                tensor_lookup, member_options));
         if (PyObject_HasAttrString(py_object, "__setstate__")) {
           SafePyObjectPtr py_setstate_call(
               PyObject_GetAttrString(py_object, "__setstate__"));
@@ -676,7 +1053,7 @@ absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
         COURIER_ASSIGN_OR_RETURN(
             SafePyObjectPtr py_items,
             DeserializePyObject(buffer.reduced_object_value().items(),
-                                tensor_lookup));
+                                tensor_lookup, member_options));
 
         // Call extend on the object.
         SafePyObjectPtr extend_fn(
@@ -696,7 +1073,7 @@ absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
         COURIER_ASSIGN_OR_RETURN(
             SafePyObjectPtr py_kvpairs,
             DeserializePyObject(buffer.reduced_object_value().kvpairs(),
-                                tensor_lookup));
+                                tensor_lookup, member_options));
 
         // Set each k/v pair on the item.
         for (int i = 0; i < PyList_Size(py_kvpairs.get()); ++i) {
@@ -709,18 +1086,33 @@ absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
       }
       return py_object;
     }
+    case SerializedObject::kArrayValue:
+      return DeserializeEncodedArray(buffer.array_value());
     case SerializedObject::PAYLOAD_NOT_SET:
       return absl::InternalError(
           "No value set. The buffer is likely corrupted.");
   }
 }
 
-absl::StatusOr<SafePyObjectPtr> DeserializePyObject(
+absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
     const SerializedObject& buffer, TensorLookup& tensor_lookup) {
-  COURIER_ASSIGN_OR_RETURN(PyObject * obj,
-                           DeserializePyObjectUnsafe(buffer, tensor_lookup));
+  return DeserializePyObjectUnsafe(buffer, tensor_lookup,
+                                   DeserializationOptions());
+}
+
+absl::StatusOr<SafePyObjectPtr> DeserializePyObject(
+    const SerializedObject& buffer, TensorLookup& tensor_lookup,
+    const DeserializationOptions& options) {
+  COURIER_ASSIGN_OR_RETURN(
+      PyObject * obj,
+      DeserializePyObjectUnsafe(buffer, tensor_lookup, options));
   return SafePyObjectPtr(obj);
 }
+
+absl::StatusOr<SafePyObjectPtr> DeserializePyObject(
+    const SerializedObject& buffer, TensorLookup& tensor_lookup) {
+  return DeserializePyObject(buffer, tensor_lookup, DeserializationOptions());
+}
 absl::StatusOr<SafePyObjectPtr> DeserializePyObject(
     const SerializedObject& buffer) {
   TensorLookup empty_lookup;
@@ -738,7 +1130,9 @@ absl::StatusOr<std::string> SerializePyObjectToString(PyObject* object) {
 absl::StatusOr<PyObject*> DeserializePyObjectFromString(
     const std::string& str) {
   SerializedObject buffer;
-  buffer.ParseFromString(str);
+  if (!buffer.ParseFromString(str)) {
+    return absl::InvalidArgumentError("Failed to parse SerializedObject.");
+  }
   COURIER_ASSIGN_OR_RETURN(auto tensor_lookup, CreateTensorLookup(buffer));
   COURIER_ASSIGN_OR_RETURN(SafePyObjectPtr obj,
                            DeserializePyObject(buffer, tensor_lookup));
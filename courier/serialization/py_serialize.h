@@ -15,11 +15,13 @@
 #ifndef COURIER_SERIALIZATION_PY_SERIALIZE_H_
 #define COURIER_SERIALIZATION_PY_SERIALIZE_H_
 
+#include <memory>
 #include <string>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "courier/platform/tensor_conversion.h"
+#include "courier/serialization/array_encoding.h"
 #include "courier/serialization/pyobject_ptr.h"
 #include "courier/serialization/serialization.pb.h"
 
@@ -27,13 +29,65 @@ namespace courier {
 
 using SafePyObjectPtr = courier::PyObjectPtr;
 
+// Options controlling how Python objects are serialized. The defaults are
+// lossless.
+struct SerializationOptions {
+  // Encoding used to transport float32 and float64 numpy arrays. Lossy
+  // encodings trade precision for bandwidth; the arrays are up-cast back to
+  // their original dtype when de-serialized.
+  EncodedArray::Encoding float_encoding = EncodedArray::RAW;
+
+  // Compression applied to the content of numpy arrays. When enabled, numeric
+  // arrays of any dtype are packed natively so that their content can be
+  // byte-shuffled and compressed.
+  CompressionOptions compression;
+};
+
+// Options controlling how Python objects are de-serialized.
+struct DeserializationOptions {
+  // If set, bytes payloads are returned as read-only memoryviews over the
+  // message being de-serialized instead of being copied into `bytes` objects.
+  // The message must outlive the memoryviews, which is ensured by holding on
+  // to `message_owner` until the last of them is released. Does not apply
+  // within reduced objects, whose reconstructors expect bytes.
+  bool bytes_as_memoryview = false;
+  std::shared_ptr<const void> message_owner;
+};
+
+// Type of `courier.Serialized` objects: `Serialized(value)` serializes
+// `value` once with the default options. Serializing a nest containing it
+// copies the resulting message in place of re-serializing `value`, which
+// saves the cost for large values sent many times. The copy is still made
+// every time the value is sent.
+//
+// Every extension module linking this library has its own copy of this
+// function. Only `courier.python.py_client` creates the type, and shares it
+// with the other modules through `NewSerializedValueTypeCapsule`: objects
+// are recognized by their type, not by their name.
+PyTypeObject* SerializedValueType();
+
+// Returns a new capsule of `SerializedValueType()`, which
+// `courier.python.py_client` exports as `_serialized_value_type`.
+PyObject* NewSerializedValueTypeCapsule();
+
+absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer,
+                               const SerializationOptions& options);
+
 absl::Status SerializePyObject(PyObject* object, SerializedObject* buffer);
 
 absl::StatusOr<SerializedObject> SerializePyObject(PyObject* object);
 
+absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
+    const SerializedObject& buffer, TensorLookup& tensor_lookup,
+    const DeserializationOptions& options);
+
 absl::StatusOr<PyObject*> DeserializePyObjectUnsafe(
     const SerializedObject& buffer, TensorLookup& tensor_lookup);
 
+absl::StatusOr<SafePyObjectPtr> DeserializePyObject(
+    const SerializedObject& buffer, TensorLookup& tensor_lookup,
+    const DeserializationOptions& options);
+
 absl::StatusOr<SafePyObjectPtr> DeserializePyObject(
     const SerializedObject& buffer, TensorLookup& tensor_lookup);
 
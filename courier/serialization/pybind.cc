@@ -15,9 +15,18 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/pytypes.h>
 
+#include <climits>
+#include <cstdint>
+#include <memory>
+
 #include "courier/platform/status_macros.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "courier/platform/tensor_conversion.h"
+#include "courier/serialization/array_encoding.h"
 #include "courier/serialization/py_serialize.h"
+#include "courier/serialization/serialization.pb.h"
 #include "pybind11_abseil/absl_casters.h"
 #include "pybind11_abseil/status_casters.h"
 
@@ -26,19 +35,109 @@ namespace {
 
 namespace py = pybind11;
 
+// Holds a contiguous view of a buffer-protocol object for its lifetime.
+class ScopedBufferView {
+ public:
+  ~ScopedBufferView() {
+    if (acquired_) PyBuffer_Release(&view_);
+  }
+
+  absl::Status Acquire(const py::handle& handle, bool writable) {
+    if (PyObject_GetBuffer(handle.ptr(), &view_,
+                           writable ? PyBUF_WRITABLE : PyBUF_SIMPLE) != 0) {
+      PyErr_Clear();
+      return absl::InvalidArgumentError(
+          writable ? "Expected a writable contiguous buffer."
+                   : "Expected a contiguous bytes-like object.");
+    }
+    acquired_ = true;
+    return absl::OkStatus();
+  }
+
+  uint8_t* data() const { return static_cast<uint8_t*>(view_.buf); }
+  size_t size() const { return view_.len; }
+
+ private:
+  Py_buffer view_;
+  bool acquired_ = false;
+};
+
+absl::StatusOr<size_t> SerializedSize(const SerializedObject& buffer) {
+  size_t size = buffer.ByteSizeLong();
+  if (size > INT_MAX) {
+    return absl::ResourceExhaustedError(
+        absl::StrCat("Serialized object of ", size,
+                     " bytes exceeds the 2GB protobuf limit."));
+  }
+  return size;
+}
+
+// Serializes directly into a bytes object of the right size instead of going
+// through an intermediate std::string.
 absl::StatusOr<py::bytes> SerializeToString(const py::handle& handle) {
-  PyObject* object = handle.ptr();
-  auto result = SerializePyObjectToString(object);
-  if (!result.ok()) {
-    return result.status();
+  SerializedObject buffer;
+  COURIER_RETURN_IF_ERROR(SerializePyObject(handle.ptr(), &buffer));
+  COURIER_ASSIGN_OR_RETURN(size_t size, SerializedSize(buffer));
+  auto bytes = py::reinterpret_steal<py::bytes>(
+      PyBytes_FromStringAndSize(nullptr, size));
+  COURIER_RET_CHECK(bytes);
+  uint8_t* target = reinterpret_cast<uint8_t*>(PyBytes_AS_STRING(bytes.ptr()));
+  {
+    py::gil_scoped_release release;
+    buffer.SerializeWithCachedSizesToArray(target);
   }
-  return py::bytes(result.value());
+  return bytes;
 }
 
-py::object DeserializeFromString(const std::string& str) {
-  auto result = DeserializePyObjectFromString(str);
-  py::object object = py::reinterpret_steal<py::object>(result.value());
-  return object;
+// Serializes into the writable buffer `target` (e.g. a bytearray, a
+// memoryview of shared memory or an mmap) and returns the number of bytes
+// written. Fails without writing if `target` is too small.
+absl::StatusOr<size_t> SerializeInto(const py::handle& handle,
+                                     const py::handle& target) {
+  SerializedObject buffer;
+  COURIER_RETURN_IF_ERROR(SerializePyObject(handle.ptr(), &buffer));
+  COURIER_ASSIGN_OR_RETURN(size_t size, SerializedSize(buffer));
+  ScopedBufferView view;
+  COURIER_RETURN_IF_ERROR(view.Acquire(target, /*writable=*/true));
+  if (view.size() < size) {
+    return absl::OutOfRangeError(
+        absl::StrCat("Serialized object requires ", size,
+                     " bytes but the buffer only holds ", view.size(), "."));
+  }
+  {
+    py::gil_scoped_release release;
+    buffer.SerializeWithCachedSizesToArray(view.data());
+  }
+  return size;
+}
+
+// Parses from any bytes-like object (bytes, bytearray, memoryview, mmap)
+// without copying it first. If `bytes_as_memoryview` is set, bytes payloads
+// are returned as memoryviews over the parsed message instead of copies.
+absl::StatusOr<py::object> DeserializeFromString(const py::handle& handle,
+                                                 bool bytes_as_memoryview) {
+  ScopedBufferView view;
+  COURIER_RETURN_IF_ERROR(view.Acquire(handle, /*writable=*/false));
+  if (view.size() > INT_MAX) {
+    return absl::InvalidArgumentError(
+        "Buffer exceeds the 2GB protobuf limit.");
+  }
+  auto buffer = std::make_shared<SerializedObject>();
+  bool parsed;
+  {
+    py::gil_scoped_release release;
+    parsed = buffer->ParseFromArray(view.data(), view.size());
+  }
+  if (!parsed) {
+    return absl::InvalidArgumentError("Failed to parse SerializedObject.");
+  }
+  DeserializationOptions options;
+  options.bytes_as_memoryview = bytes_as_memoryview;
+  options.message_owner = buffer;
+  COURIER_ASSIGN_OR_RETURN(auto tensor_lookup, CreateTensorLookup(*buffer));
+  COURIER_ASSIGN_OR_RETURN(
+      auto result, DeserializePyObjectUnsafe(*buffer, tensor_lookup, options));
+  return py::reinterpret_steal<py::object>(result);
 }
 
 absl::StatusOr<SerializedObject> SerializeToProto(const py::handle& handle) {
@@ -58,16 +157,34 @@ absl::StatusOr<py::object> DeserializeFromProto(
   return py::reinterpret_steal<py::object>(result);
 }
 
+py::dict GetCompressionStatsDict() {
+  CompressionStats stats = GetCompressionStats();
+  py::dict result;
+  result["compressed"] = stats.compressed;
+  result["skipped_too_small"] = stats.skipped_too_small;
+  result["skipped_incompressible"] = stats.skipped_incompressible;
+  result["uncompressed_bytes"] = stats.uncompressed_bytes;
+  result["compressed_bytes"] = stats.compressed_bytes;
+  return result;
+}
+
 PYBIND11_MODULE(pybind, m) {
   py::google::ImportStatusModule();
 
   m.def("SerializeToString", &SerializeToString,
         "Serializes Object to a string");
+  m.def("SerializeInto", &SerializeInto,
+        "Serializes object into a writable buffer and returns the number of "
+        "bytes written");
   m.def("DeserializeFromString", &DeserializeFromString,
-        "Deserializes object from a string");
+        "Deserializes object from a bytes-like object", py::arg("data"),
+        py::arg("bytes_as_memoryview") = false);
   m.def("SerializeToProto", &SerializeToProto, "Serializes object to a proto");
   m.def("DeserializeFromProto", &DeserializeFromProto,
         "Deserializes object from a proto");
+  m.def("CompressionStats", &GetCompressionStatsDict,
+        "Returns counters describing the array compression done in this "
+        "process");
 }
 
 }  // namespace
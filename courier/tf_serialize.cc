@@ -14,10 +14,13 @@
 
 #include "courier/tf_serialize.h"
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "courier/serialization/array_encoding.h"
 #include "courier/serialization/serialization.pb.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -26,10 +29,47 @@
 #include "tensorflow/core/platform/tstring.h"
 
 namespace courier {
+namespace {
+
+// Up-casts numpy arrays which were sent with a (possibly lossy) transport
+// encoding back to a tensor of their original dtype.
+absl::Status DecodeArrayToTensor(const EncodedArray& encoded,
+                                 tensorflow::Tensor* tensor_value,
+                                 tensorflow::Allocator* allocator) {
+  // The shape comes from the peer: `AddDim` would crash on an invalid one.
+  std::vector<int64_t> dims(encoded.shape().begin(), encoded.shape().end());
+  tensorflow::TensorShape shape;
+  if (!tensorflow::TensorShapeUtils::MakeShape(dims, &shape).ok()) {
+    return absl::InvalidArgumentError("Invalid shape of an encoded array.");
+  }
+  if (encoded.dtype() == "<f4") {
+    *tensor_value = tensorflow::Tensor(allocator, tensorflow::DT_FLOAT, shape);
+    return DecodeFloatArray(encoded, tensor_value->NumElements(),
+                            tensor_value->flat<float>().data());
+  }
+  if (encoded.dtype() == "<f8") {
+    *tensor_value =
+        tensorflow::Tensor(allocator, tensorflow::DT_DOUBLE, shape);
+    return DecodeFloatArray(encoded, tensor_value->NumElements(),
+                            tensor_value->flat<double>().data());
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unsupported array dtype: ", encoded.dtype()));
+}
+
+}  // namespace
 
 absl::Status DeserializeTensor(const courier::SerializedObject& buffer,
                                tensorflow::TensorProto* tensor_value,
                                tensorflow::Allocator* allocator) {
+  if (buffer.has_array_value()) {
+    tensorflow::Tensor tensor;
+    absl::Status status =
+        DecodeArrayToTensor(buffer.array_value(), &tensor, allocator);
+    if (!status.ok()) return status;
+    tensor.AsProtoTensorContent(tensor_value);
+    return absl::OkStatus();
+  }
   if (!buffer.has_tensor_value()) {
     return absl::InternalError("TensorProto did not exist");
   }
@@ -48,6 +88,9 @@ absl::Status DeserializeTensor(const courier::SerializedObject& buffer,
     }
     return absl::OkStatus();
   }
+  if (buffer.has_array_value()) {
+    return DecodeArrayToTensor(buffer.array_value(), tensor_value, allocator);
+  }
 
   tensorflow::TensorShape shape;
 